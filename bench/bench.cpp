@@ -0,0 +1,824 @@
+//////////////////////////////////////////////////////////////////////////
+//  Beyond Help Module Collection
+//  for VCV Rack By Juriel Garcia Sanchez
+//
+//  Headless benchmark, run with `make bench [BENCH_FRAMES=n]`
+//
+//  Drives the modules through Model::createModule() and process(),
+//  the same way the engine does, and reports ns/sample, events/sec
+//  and peak resident memory. The recorder's takes and the SMF encoder's
+//  files are read back and checked, the encoder's also against midifile's
+//  own writer, TickClock is run for hours to check it doesn't drift, and
+//  Tension's curves are checked against the double curves at every precision.
+//  A failed check fails the run.
+//
+//  See ./LICENSE.md for all licenses
+////////////////////////////////////////////////////////////////////////
+
+#include "plugin.hpp"
+#include "smfencoder.hpp"
+#include "penners.hpp"
+#include "MidiFile.h"
+#include <chrono>
+#include <cstring>
+#include <sys/resource.h>
+
+// Port and param ids, kept in step with the module enums
+namespace TensionIds
+{
+enum { TRIGGER_PARAM, RESET_PARAM, SHAPESLIDER_PARAM, RATIOSLIDER_PARAM };
+enum { CLOCKINPUT_INPUT, TRIGGER_INPUT, SHAPE_INPUT, MODE_INPUT, RATIO_INPUT };
+enum { GATEOUTPUT_OUTPUT, OUTPUT_OUTPUT };
+} // namespace TensionIds
+
+namespace RecorderIds
+{
+enum { TRIGGER_PARAM };
+enum { CLOCK_INPUT, RECORD_INPUT, VOLTAGE_INPUT, GATE_INPUT, VELOCITY_INPUT, CC_INPUT };
+} // namespace RecorderIds
+
+static const float SAMPLE_RATE = 48000.f;
+static const int CHANNEL_COUNTS[] = {1, 4, 16};
+static const float CLOCK_RATES[] = {2.f, 50.f}; // Hz
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds(Clock::time_point from, Clock::time_point to)
+{
+	return std::chrono::duration<double>(to - from).count();
+}
+
+static long peakMemoryKb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+/// Square wave, high for the first half of each period, channels spread evenly over the period.
+/// Counters rather than a modulo per sample, so the driver stays cheap next to the module
+struct Square
+{
+	uint32_t phase[PORT_MAX_CHANNELS] = {};
+	uint32_t period = 2;
+	int channels = 1;
+
+	Square(int channels, uint32_t period, uint32_t offset = 0) : period(period), channels(channels)
+	{
+		for (int c = 0; c < channels; c++)
+			phase[c] = (offset + (uint64_t)period * c / channels) % period;
+	}
+
+	/// True for the channels that wrapped, ie. started a new period
+	void process(Input &input, bool *wrapped = NULL)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			if (++phase[c] >= period)
+				phase[c] = 0;
+			if (wrapped)
+				wrapped[c] = phase[c] == 0;
+			input.setVoltage(phase[c] < period / 2 ? 10.f : 0.f, c);
+		}
+	}
+};
+
+static void configure(Module *module, const char *key, long long value)
+{
+	json_t *json = json_object();
+	json_object_set_new(json, key, json_integer(value));
+	module->dataFromJson(json);
+}
+
+struct Result
+{
+	double nsPerSample;
+	double eventsPerSecond;
+};
+
+/// Clock and trigger both run at clockRate, triggers are events.
+/// With morph the shape and ratio CV sweep every sample
+static Result runTension(int type, int mode, int precision, int blockSize, int channels, float clockRate, uint64_t frames, bool morph = false)
+{
+	using namespace TensionIds;
+	Module *module = modelTension->createModule();
+	configure(module, "easeMode", mode);
+	configure(module, "precision", precision);
+	configure(module, "blockSize", blockSize);
+	module->params[SHAPESLIDER_PARAM].setValue(type);
+
+	Input &clock = module->inputs[CLOCKINPUT_INPUT];
+	Input &trigger = module->inputs[TRIGGER_INPUT];
+	Input &shapeCv = module->inputs[SHAPE_INPUT];
+	Input &ratioCv = module->inputs[RATIO_INPUT];
+	clock.channels = channels;
+	trigger.channels = channels;
+	if (morph)
+	{
+		shapeCv.channels = channels;
+		ratioCv.channels = channels;
+	}
+	module->outputs[GATEOUTPUT_OUTPUT].channels = 1;
+	module->outputs[OUTPUT_OUTPUT].channels = 1;
+
+	Module::ProcessArgs args{SAMPLE_RATE, 1.f / SAMPLE_RATE};
+	uint32_t period = std::max<uint32_t>(2, SAMPLE_RATE / clockRate);
+	Square clockWave(channels, period), triggerWave(channels, period, period / 4);
+	uint64_t events = 0;
+	float sink = 0.f;
+
+	auto start = Clock::now();
+	for (uint64_t frame = 0; frame < frames; frame++)
+	{
+		clockWave.process(clock);
+		triggerWave.process(trigger);
+		if (morph)
+		{
+			const float sweep = (frame % 48000) / 4800.f;
+			for (int c = 0; c < channels; c++)
+			{
+				shapeCv.setVoltage(sweep, c);
+				ratioCv.setVoltage(sweep * 0.1f, c);
+			}
+		}
+		module->process(args);
+		sink += module->outputs[OUTPUT_OUTPUT].getVoltage(channels - 1);
+	}
+	auto end = Clock::now();
+	events = frames / period * channels;
+
+	// Keeps the output loads from being optimized away
+	if (sink == 12345.f)
+		printf(" ");
+
+	delete module;
+	double elapsed = seconds(start, end);
+	return Result{elapsed * 1e9 / frames, events / elapsed};
+}
+
+static long fileSize(const std::string &path)
+{
+	std::FILE *file = std::fopen(path.c_str(), "rb");
+	if (!file)
+		return -1;
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	std::fclose(file);
+	return size;
+}
+
+/// Events of one track as read back, (tick, bytes), with meta events as FF, type then data
+typedef std::vector<std::pair<uint32_t, std::vector<uint8_t>>> SmfTrack;
+
+static bool readVariableLength(const std::vector<uint8_t> &data, size_t &at, size_t end, uint32_t &value)
+{
+	value = 0;
+	for (int i = 0; i < 4 && at < end; i++)
+	{
+		const uint8_t byte = data[at++];
+		value = value << 7 | (byte & 0x7F);
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+/// A Standard MIDI File read without midifile, so takes can be checked whether or not it is there.
+/// Ticks are absolute and each track is sorted, end of track aside. Empty when the file is malformed
+static std::vector<SmfTrack> readSmf(const std::string &path)
+{
+	std::vector<SmfTrack> tracks;
+	std::FILE *file = std::fopen(path.c_str(), "rb");
+	if (!file)
+		return tracks;
+	std::vector<uint8_t> data;
+	uint8_t buffer[4096];
+	size_t read;
+	while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + read);
+	std::fclose(file);
+
+	auto word = [&](size_t at) { return uint32_t(data[at]) << 24 | data[at + 1] << 16 | data[at + 2] << 8 | data[at + 3]; };
+	if (data.size() < 14 || std::memcmp(data.data(), "MThd", 4) != 0 || word(4) != 6)
+		return tracks;
+	const int trackCount = data[10] << 8 | data[11];
+
+	size_t at = 14;
+	for (int t = 0; t < trackCount; t++)
+	{
+		if (at + 8 > data.size() || std::memcmp(&data[at], "MTrk", 4) != 0)
+			return std::vector<SmfTrack>();
+		const size_t end = at + 8 + word(at + 4);
+		if (end > data.size())
+			return std::vector<SmfTrack>();
+		at += 8;
+
+		SmfTrack track;
+		uint32_t tick = 0;
+		uint8_t runningStatus = 0;
+		bool ended = false;
+		while (at < end && !ended)
+		{
+			uint32_t delta, length;
+			if (!readVariableLength(data, at, end, delta) || at >= end)
+				return std::vector<SmfTrack>();
+			tick += delta;
+
+			std::vector<uint8_t> bytes;
+			if (data[at] == 0xFF)
+			{
+				const uint8_t type = data[at + 1];
+				at += 2;
+				if (!readVariableLength(data, at, end, length) || at + length > end)
+					return std::vector<SmfTrack>();
+				ended = type == 0x2F;
+				bytes.push_back(0xFF);
+				bytes.push_back(type);
+				bytes.insert(bytes.end(), data.begin() + at, data.begin() + at + length);
+				at += length;
+			}
+			else
+			{
+				if (data[at] & 0x80)
+					runningStatus = data[at++];
+				if (runningStatus < 0x80 || runningStatus >= 0xF0)
+					return std::vector<SmfTrack>();
+				length = (runningStatus & 0xE0) == 0xC0 ? 1 : 2; // Program change and channel pressure
+				if (at + length > end)
+					return std::vector<SmfTrack>();
+				bytes.push_back(runningStatus);
+				bytes.insert(bytes.end(), data.begin() + at, data.begin() + at + length);
+				at += length;
+			}
+			if (!ended)
+				track.push_back(std::make_pair(tick, bytes));
+		}
+		if (!ended)
+			return std::vector<SmfTrack>();
+		std::sort(track.begin(), track.end());
+		tracks.push_back(track);
+		at = end;
+	}
+	return tracks;
+}
+
+/// The recorder's take of runRecorder's gates, read back: every channel plays its pitch sequence,
+/// a note per gate period, each NoteOn followed by its NoteOff
+static bool checkTake(const std::string &path, int channels, uint32_t period, uint64_t frames)
+{
+	const std::vector<SmfTrack> tracks = readSmf(path);
+	if (tracks.empty())
+		return false;
+
+	// 120 BPM, the gates are sampled every 16 samples
+	const double ticksPerPeriod = period / SAMPLE_RATE * 2.0 * 960.0;
+	const double tolerance = 16.0 / SAMPLE_RATE * 2.0 * 960.0 + 1.0;
+	const int64_t expected = frames / period;
+
+	for (int c = 0; c < channels; c++)
+	{
+		int64_t notes = 0;
+		int held = -1;
+		int previous = -1;
+		uint32_t previousTick = 0;
+		for (const SmfTrack &track : tracks)
+		{
+			for (const auto &event : track)
+			{
+				const std::vector<uint8_t> &bytes = event.second;
+				const uint8_t type = bytes[0] & 0xF0;
+				if ((type != 0x90 && type != 0x80) || (bytes[0] & 0x0F) != c)
+					continue;
+
+				if (type == 0x90 && bytes[2] > 0)
+				{
+					if (held >= 0)
+						return false;
+					if (previous >= 0 && bytes[1] - 48 != (previous - 48 + 7) % 24)
+						return false;
+					// A gate already high when the take started is late
+					if (notes > 1 && std::fabs(event.first - previousTick - ticksPerPeriod) > tolerance)
+						return false;
+					held = previous = bytes[1];
+					previousTick = event.first;
+					notes++;
+				}
+				else
+				{
+					if (held != bytes[1])
+						return false;
+					held = -1;
+				}
+			}
+		}
+		// A period either side of the frame count, plus the note of a gate already high at the start
+		if (held >= 0 || notes < expected - 1 || notes > expected + 2)
+			return false;
+	}
+	return true;
+}
+
+/// Gates at gateRate per channel with a new pitch on every gate, recorded as a single take.
+/// The take's file size is -1 when it wasn't written
+static Result runRecorder(bool streamToDisk, int channels, float gateRate, uint64_t frames, double *writeSeconds, long *fileBytes, bool *readsBack)
+{
+	using namespace RecorderIds;
+	std::remove("build/bench/take.mid");
+	// The widget stands in for the UI, which passes the engine's start and stop on to the writer thread
+	ModuleWidget *widget = modelTenseMidiRecorder->createModuleWidget();
+	Module *module = widget->module;
+	json_t *json = json_object();
+	json_object_set_new(json, "path", json_string("build/bench/take.mid"));
+	json_object_set_new(json, "shouldIncrementPath", json_boolean(false));
+	json_object_set_new(json, "streamToDisk", json_boolean(streamToDisk));
+	module->dataFromJson(json);
+
+	Input &gate = module->inputs[GATE_INPUT];
+	Input &voltage = module->inputs[VOLTAGE_INPUT];
+	Input &velocity = module->inputs[VELOCITY_INPUT];
+	gate.channels = channels;
+	voltage.channels = channels;
+	velocity.channels = channels;
+
+	Module::ProcessArgs args{SAMPLE_RATE, 1.f / SAMPLE_RATE};
+	uint32_t period = std::max<uint32_t>(2, SAMPLE_RATE / gateRate);
+	const uint64_t uiFrames = SAMPLE_RATE / 60;
+	Square gateWave(channels, period);
+	bool wrapped[PORT_MAX_CHANNELS];
+	int pitches[PORT_MAX_CHANNELS] = {};
+	for (int c = 0; c < channels; c++)
+	{
+		voltage.setVoltage(-1.f, c);
+		velocity.setVoltage(5.f + c / 4.f, c);
+	}
+
+	// The record button latches, recording follows its level, polled every 32 samples
+	module->params[TRIGGER_PARAM].setValue(1.f);
+
+	auto start = Clock::now();
+	for (uint64_t frame = 0; frame < frames; frame++)
+	{
+		gateWave.process(gate, wrapped);
+		for (int c = 0; c < channels; c++)
+		{
+			if (wrapped[c])
+			{
+				pitches[c] = (pitches[c] + 7) % 24;
+				voltage.setVoltage(pitches[c] / 12.f - 1.f, c);
+			}
+		}
+		module->process(args);
+		if (frame % uiFrames == 0)
+			widget->step();
+	}
+	auto end = Clock::now();
+
+	// Stopped from the button, the take is finished on the writer thread or, if it hasn't got to it, when the module is destroyed
+	module->params[TRIGGER_PARAM].setValue(0.f);
+	for (int i = 0; i < 64; i++)
+		module->process(args);
+	widget->step();
+
+	auto writeStart = Clock::now();
+	delete widget;
+	*writeSeconds = seconds(writeStart, Clock::now());
+	*fileBytes = fileSize("build/bench/take.mid");
+	*readsBack = checkTake("build/bench/take.mid", channels, period, frames);
+
+	double elapsed = seconds(start, end);
+	uint64_t events = frames / period * channels * 2; // NoteOn and NoteOff
+	return Result{elapsed * 1e9 / frames, events / elapsed};
+}
+
+/// Notes over 16 channels on 4 tracks, with a tempo change every 10000 events
+static void fillTake(ChunkedArena<TakeEvent> &take, size_t events)
+{
+	take.clear();
+	uint32_t tick = 0;
+	bool held[16] = {};
+	for (size_t i = 0; i < events; i++)
+	{
+		tick += i % 3;
+		if (i % 10000 == 0)
+		{
+			const uint32_t microsecondsPerQN = 400000 + i % 200000;
+			take.push(TakeEvent{tick, TakeEvent::TEMPO, {uint8_t(microsecondsPerQN >> 16), uint8_t(microsecondsPerQN >> 8), uint8_t(microsecondsPerQN)}});
+			continue;
+		}
+		const int channel = i % 16;
+		const uint8_t note = 36 + (i / 16) % 48;
+		const uint8_t status = (held[channel] ? 0x80 : 0x90) | channel;
+		take.push(TakeEvent{tick, status, {uint8_t(channel % 4), note, uint8_t(held[channel] ? 0 : 100)}});
+		held[channel] ^= true;
+	}
+}
+
+/// Worst error of each precision against the double curves, sampled much finer than the table's knots
+struct CurveErrors
+{
+	double exact;
+	double table;
+	double economy;
+};
+
+static CurveErrors curveErrors(Ease::Type type, Ease::Mode mode)
+{
+	static const int STEPS = 1 << 16;
+	std::vector<float> x(STEPS + 1), out(STEPS + 1);
+	for (int i = 0; i <= STEPS; i++)
+		x[i] = float(i) / STEPS;
+
+	// An odd count, so the block's padded remainder is checked as well
+	Ease::EvaluateBlock(type, mode, x.data(), out.data(), x.size());
+	const Ease::Func f = Ease::EnumToFunction(type);
+	const Ease::Curve4 economy = Ease::EnumToEconomyFunction(type, mode);
+
+	// Tables through the morph crossfade, the one path that reads them for every curve
+	const Ease::Table *tables = &Ease::GetTables().table[0][0];
+	const rack::simd::int32_4 index = type * 3 + mode;
+
+	CurveErrors errors = {};
+	for (int i = 0; i <= STEPS; i++)
+	{
+		const double exact = f(mode, x[i]);
+		errors.exact = std::max(errors.exact, std::fabs(out[i] - exact));
+		errors.table = std::max(errors.table, std::fabs(Ease::Lookup(tables, index, index, 0.f, Ease::float_4(x[i]))[0] - exact));
+		errors.economy = std::max(errors.economy, std::fabs(economy(Ease::float_4(x[i]))[0] - exact));
+	}
+	return errors;
+}
+
+static float curveSink = 0.f;
+
+/// Best ns per float_4 of one curve, evaluated the way Tension's kernels do. x is spread over [0, 1]
+/// out of order, so a table is read all over rather than one segment after the next
+template <Ease::Type type, Ease::Mode mode, Ease::Precision precision>
+static double curveCost(const std::vector<float> &x)
+{
+	const Ease::Table &table = Ease::GetTable(type, mode);
+	Ease::float_4 sum = 0.f;
+	double best = 1e9;
+	for (int run = 0; run < 16; run++)
+	{
+		auto start = Clock::now();
+		for (size_t i = 0; i < x.size(); i += 4)
+		{
+			const Ease::float_4 v = Ease::float_4::load(&x[i]);
+			sum += precision == Ease::TABLE	  ? Ease::Lookup(table, v)
+				   : precision == Ease::ECONOMY ? Ease::EvaluateEconomy<type, mode>(v)
+												: Ease::Evaluate<type, mode>(v);
+		}
+		best = std::min(best, seconds(start, Clock::now()) * 1e9 / (x.size() / 4));
+	}
+	curveSink += sum[0];
+	return best;
+}
+
+using CurveCost = double (*)(const std::vector<float> &x);
+
+static CurveCost curveCostFunction(Ease::Type type, Ease::Mode mode, Ease::Precision precision)
+{
+#define CURVE_COSTS(type, mode) {&curveCost<type, mode, Ease::EXACT>, &curveCost<type, mode, Ease::TABLE>, &curveCost<type, mode, Ease::ECONOMY>}
+#define CURVE_MODE_COSTS(type) {CURVE_COSTS(type, Ease::IN), CURVE_COSTS(type, Ease::OUT), CURVE_COSTS(type, Ease::BOTH)}
+	static const CurveCost functions[Ease::COUNT][3][3] = {
+		CURVE_MODE_COSTS(Ease::LINEAR),
+		CURVE_MODE_COSTS(Ease::SINE),
+		CURVE_MODE_COSTS(Ease::EXPO),
+		CURVE_MODE_COSTS(Ease::CIRC),
+		CURVE_MODE_COSTS(Ease::CUBIC),
+		CURVE_MODE_COSTS(Ease::QUAD),
+		CURVE_MODE_COSTS(Ease::QUART),
+		CURVE_MODE_COSTS(Ease::QUINT),
+		CURVE_MODE_COSTS(Ease::BACK),
+		CURVE_MODE_COSTS(Ease::ELASTIC),
+		CURVE_MODE_COSTS(Ease::BOUNCE),
+	};
+#undef CURVE_MODE_COSTS
+#undef CURVE_COSTS
+	return functions[type][mode][precision];
+}
+
+/// Largest distance, in ticks, between the tick TickClock gives a second of audio and the tick a
+/// player reaches at that second from the tempo map, over hours at one sample rate. A bpm of 0
+/// changes tempo every 7 seconds
+static double tickDrift(double sampleRate, double bpm, int hours)
+{
+	static const double TEMPOS[] = {97.0, 120.0, 61.3, 174.0, 133.33};
+	TickClock clock(960);
+	clock.reset(sampleRate);
+	uint32_t microsecondsPerQN = clock.setTempo(0, bpm > 0.0 ? bpm : TEMPOS[0]);
+
+	// The player's side, the playback time at the last tempo change
+	uint32_t tempoTick = 0;
+	double tempoTime = 0.0;
+	double drift = 0.0;
+	for (int second = 1; second <= hours * 3600; second++)
+	{
+		const uint64_t frame = uint64_t(second * sampleRate);
+		const double time = frame / sampleRate;
+		const uint32_t tick = clock.toTick(frame);
+		const double ticks = tempoTick + (time - tempoTime) * 1e6 * 960.0 / microsecondsPerQN;
+		drift = std::max(drift, std::fabs(tick - ticks));
+
+		if (bpm <= 0.0 && second % 7 == 0)
+		{
+			tempoTime += double(tick - tempoTick) * microsecondsPerQN / (1e6 * 960.0);
+			tempoTick = tick;
+			microsecondsPerQN = clock.setTempo(frame, TEMPOS[second / 7 % 5]);
+		}
+	}
+	return drift;
+}
+
+/// The tracks the take should read back as, tempo on the first
+static std::vector<SmfTrack> expectedTracks(const ChunkedArena<TakeEvent> &take)
+{
+	std::vector<SmfTrack> tracks(1);
+	for (size_t i = 0; i < take.size(); i++)
+	{
+		const TakeEvent &event = take[i];
+		if (event.status == TakeEvent::TEMPO)
+		{
+			tracks[0].push_back(std::make_pair(event.tick, std::vector<uint8_t>{0xFF, 0x51, event.bytes[0], event.bytes[1], event.bytes[2]}));
+			continue;
+		}
+		if (event.bytes[0] >= tracks.size())
+			tracks.resize(event.bytes[0] + 1);
+		tracks[event.bytes[0]].push_back(std::make_pair(event.tick, std::vector<uint8_t>{event.status, event.bytes[1], event.bytes[2]}));
+	}
+	for (SmfTrack &track : tracks)
+		std::sort(track.begin(), track.end());
+	return tracks;
+}
+
+/// The take through smf::MidiFile, as the recorder used to write it
+static bool writeWithMidifile(const std::string &path, const ChunkedArena<TakeEvent> &take)
+{
+	smf::MidiFile midiFile;
+	midiFile.setTicksPerQuarterNote(960);
+	std::vector<uint8_t> message(3);
+	for (size_t i = 0; i < take.size(); i++)
+	{
+		const TakeEvent &event = take[i];
+		if (event.status == TakeEvent::TEMPO)
+		{
+			midiFile.addTempo(0, event.tick, 60000000.0 / (event.bytes[0] << 16 | event.bytes[1] << 8 | event.bytes[2]));
+			continue;
+		}
+		if (event.bytes[0] >= midiFile.getTrackCount())
+			midiFile.addTracks(event.bytes[0] + 1 - midiFile.getTrackCount());
+		message[0] = event.status;
+		message[1] = event.bytes[1];
+		message[2] = event.bytes[2];
+		midiFile.addEvent(event.bytes[0], event.tick, message);
+	}
+	midiFile.sortTracks();
+	return midiFile.write(path);
+}
+
+/// Every event of each track, in order within each tick, end of track aside
+static std::vector<std::vector<std::pair<int, std::vector<uint8_t>>>> readBack(const std::string &path)
+{
+	smf::MidiFile midiFile;
+	midiFile.read(path);
+	std::vector<std::vector<std::pair<int, std::vector<uint8_t>>>> tracks(midiFile.getTrackCount());
+	for (int t = 0; t < midiFile.getTrackCount(); t++)
+	{
+		for (int i = 0; i < midiFile[t].size(); i++)
+		{
+			if (!midiFile[t][i].isEndOfTrack())
+				tracks[t].push_back(std::make_pair(midiFile[t][i].tick, std::vector<uint8_t>(midiFile[t][i].begin(), midiFile[t][i].end())));
+		}
+		std::sort(tracks[t].begin(), tracks[t].end());
+	}
+	return tracks;
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t frames = argc > 1 ? strtoull(argv[1], NULL, 10) : 1 << 20;
+
+	Plugin plugin;
+	init(&plugin);
+
+	printf("%llu frames per run at %g Hz, peak memory at start %ld kB\n\n",
+		   (unsigned long long)frames, SAMPLE_RATE, peakMemoryKb());
+
+	// Checks that go wrong fail the run, after the timings are printed
+	bool failed = false;
+
+	printf("Tension, exact precision, no block\n");
+	printf("%-8s %-5s %3s %6s %10s %12s\n", "type", "mode", "ch", "clock", "ns/sample", "events/s");
+	double total = 0.0;
+	int runs = 0;
+	for (int type = 0; type < Ease::COUNT; type++)
+	{
+		for (int mode = Ease::IN; mode <= Ease::BOTH; mode++)
+		{
+			for (int channels : CHANNEL_COUNTS)
+			{
+				for (float clockRate : CLOCK_RATES)
+				{
+					Result result = runTension(type, mode, Ease::EXACT, 1, channels, clockRate, frames);
+					printf("%-8s %-5s %3d %5gHz %10.1f %12.0f\n", Ease::TypeStrings[type], Ease::ModeStrings[mode],
+						   channels, clockRate, result.nsPerSample, result.eventsPerSecond);
+					total += result.nsPerSample;
+					runs++;
+				}
+			}
+		}
+	}
+	printf("mean %.1f ns/sample over %d runs\n\n", total / runs, runs);
+
+	// In mode, where all of these have their own Table and Economy curves bar Linear. Best of three, the
+	// differences are a few percent of the module's time and would drown in the noise of a single run
+	printf("Tension, 16 channels at %gHz, In mode, by precision and block size\n", CLOCK_RATES[0]);
+	printf("%-8s %-7s %5s %10s\n", "type", "prec", "block", "ns/sample");
+	static const int TYPES[] = {Ease::LINEAR, Ease::SINE, Ease::EXPO, Ease::ELASTIC};
+	static const int BLOCK_SIZES[] = {1, 8, 16, 32};
+	for (int type : TYPES)
+	{
+		for (int precision = Ease::EXACT; precision <= Ease::ECONOMY; precision++)
+		{
+			for (int blockSize : BLOCK_SIZES)
+			{
+				double nsPerSample = 1e9;
+				for (int run = 0; run < 3; run++)
+					nsPerSample = std::min(nsPerSample, runTension(type, Ease::IN, precision, blockSize, 16, CLOCK_RATES[0], frames).nsPerSample);
+				printf("%-8s %-7s %5d %10.1f\n", Ease::TypeStrings[type], Ease::PrecisionStrings[precision],
+					   blockSize, nsPerSample);
+			}
+		}
+	}
+	printf("\n");
+
+	printf("Tension, shape and ratio CV sweeping at audio rate\n");
+	printf("%3s %5s %10s\n", "ch", "block", "ns/sample");
+	for (int channels : CHANNEL_COUNTS)
+	{
+		for (int blockSize : BLOCK_SIZES)
+		{
+			Result result = runTension(Ease::LINEAR, Ease::BOTH, Ease::EXACT, blockSize, channels, CLOCK_RATES[0], frames, true);
+			printf("%3d %5d %10.1f\n", channels, blockSize, result.nsPerSample);
+		}
+	}
+	printf("\n");
+
+	// What each precision costs, and what Table and Economy actually run for the curve
+	printf("Curve cost in ns per float_4\n");
+	printf("%-8s %-5s %8s %8s %8s  %-7s %-7s\n", "type", "mode", "exact", "table", "economy", "table", "economy");
+	{
+		std::vector<float> x(4096);
+		for (size_t i = 0; i < x.size(); i++)
+			x[i] = float((i * 2654435761u) % 1000003) / 1000003.f;
+		for (int type = 0; type < Ease::COUNT; type++)
+		{
+			for (int mode = Ease::IN; mode <= Ease::BOTH; mode++)
+			{
+				printf("%-8s %-5s", Ease::TypeStrings[type], Ease::ModeStrings[mode]);
+				for (int precision = Ease::EXACT; precision <= Ease::ECONOMY; precision++)
+					printf(" %8.2f", curveCostFunction(Ease::Type(type), Ease::Mode(mode), Ease::Precision(precision))(x));
+				printf("  %-7s %-7s\n", Ease::PrecisionStrings[Ease::Effective(Ease::Type(type), Ease::Mode(mode), Ease::TABLE)],
+					   Ease::PrecisionStrings[Ease::Effective(Ease::Type(type), Ease::Mode(mode), Ease::ECONOMY)]);
+			}
+		}
+		if (curveSink == 12345.f)
+			printf("\n");
+	}
+	printf("\n");
+
+	// Exact and Economy as documented in penners.hpp. Table as measured when baked and shown in Tension's
+	// menu, with a margin since the bake measures 16 points per segment and can miss the worst by a few percent.
+	// Where the table is as good as Exact, float rounding decides, so Exact's bound holds instead
+	static const double EXACT_ERROR = 5e-6;
+	static const double ECONOMY_ERROR = 1e-5;
+	static const double TABLE_ERROR_MARGIN = 1.1;
+	printf("Curve accuracy against the double curves, worst of each precision\n");
+	printf("%-8s %-5s %10s %10s %10s\n", "type", "mode", "exact", "table", "economy");
+	for (int type = 0; type < Ease::COUNT; type++)
+	{
+		for (int mode = Ease::IN; mode <= Ease::BOTH; mode++)
+		{
+			const CurveErrors errors = curveErrors(Ease::Type(type), Ease::Mode(mode));
+			const bool accurate = errors.exact <= EXACT_ERROR && errors.economy <= ECONOMY_ERROR &&
+								  errors.table <= std::max(Ease::GetTable(Ease::Type(type), Ease::Mode(mode)).error * TABLE_ERROR_MARGIN, EXACT_ERROR);
+			printf("%-8s %-5s %10.2e %10.2e %10.2e%s\n", Ease::TypeStrings[type], Ease::ModeStrings[mode],
+				   errors.exact, errors.table, errors.economy, accurate ? "" : " INACCURATE");
+			failed |= !accurate;
+		}
+	}
+	printf("\n");
+
+	printf("TenseMidiRecorder, one take per run\n");
+	printf("%-7s %3s %6s %10s %12s %9s %8s\n", "stream", "ch", "gate", "ns/sample", "events/s", "write ms", "file kB");
+	static const float GATE_RATES[] = {4.f, 100.f};
+	for (int streamToDisk = 0; streamToDisk <= 1; streamToDisk++)
+	{
+		for (int channels : CHANNEL_COUNTS)
+		{
+			for (float gateRate : GATE_RATES)
+			{
+				double writeSeconds = 0.0;
+				long fileBytes = -1;
+				bool readsBack = false;
+				Result result = runRecorder(streamToDisk, channels, gateRate, frames, &writeSeconds, &fileBytes, &readsBack);
+				printf("%-7s %3d %5gHz %10.1f %12.0f %9.2f %8ld%s\n", streamToDisk ? "yes" : "no", channels, gateRate,
+					   result.nsPerSample, result.eventsPerSecond, writeSeconds * 1e3, fileBytes / 1000,
+					   fileBytes <= 0 ? " no take written" : readsBack ? "" : " take reads back WRONG");
+				failed |= fileBytes <= 0 || !readsBack;
+			}
+		}
+	}
+	printf("\n");
+
+	printf("Patch load, widgets and modules created and destroyed together\n");
+	printf("%-18s %5s %10s %12s\n", "module", "count", "load ms", "us/instance");
+	static const int PATCH_SIZE = 100;
+	for (Model *model : {modelTension, modelTenseMidiRecorder})
+	{
+		std::vector<ModuleWidget *> widgets;
+		auto start = Clock::now();
+		for (int i = 0; i < PATCH_SIZE; i++)
+			widgets.push_back(model->createModuleWidget());
+		double elapsed = seconds(start, Clock::now());
+		for (ModuleWidget *widget : widgets)
+			delete widget;
+		printf("%-18s %5d %10.2f %12.1f\n", model->slug.c_str(), PATCH_SIZE, elapsed * 1e3, elapsed * 1e6 / PATCH_SIZE);
+	}
+	printf("\n");
+
+	// Before Resources every instance built the asset path and went through the window's cache
+	printf("Artwork lookup, ns per handle\n");
+	printf("%-14s %10s %10s\n", "asset", "by path", "Resources");
+	static const int LOOKUPS = 100000;
+	struct Asset
+	{
+		const char *name;
+		const char *path;
+		Resources::SvgIds id;
+	};
+	for (const Asset &a : {Asset{"panel", "res/Tension.svg", Resources::TENSION_PANEL},
+						   Asset{"button", "res/components/TToggleButton_0.svg", Resources::TOGGLE_BUTTON_0}})
+	{
+		// Both hold a handle first, so either route only looks it up
+		std::shared_ptr<Svg> held = Resources::getSvg(a.id);
+		long handles = 0;
+		auto start = Clock::now();
+		for (int i = 0; i < LOOKUPS; i++)
+			handles += APP->window->loadSvg(asset::plugin(pluginInstance, a.path)) == held;
+		double byPath = seconds(start, Clock::now());
+		start = Clock::now();
+		for (int i = 0; i < LOOKUPS; i++)
+			handles += Resources::getSvg(a.id) == held;
+		double shared = seconds(start, Clock::now());
+		printf("%-14s %10.1f %10.1f%s\n", a.name, byPath * 1e9 / LOOKUPS, shared * 1e9 / LOOKUPS,
+			   handles == 2 * LOOKUPS ? "" : " handles DIFFERENT");
+		failed |= handles != 2 * LOOKUPS;
+	}
+	printf("\n");
+
+	static const int DRIFT_HOURS = 6;
+	printf("TickClock drift over %d hours, in ticks\n", DRIFT_HOURS);
+	printf("%7s %8s %7s\n", "rate", "bpm", "drift");
+	for (double sampleRate : {44100.0, 48000.0, 96000.0})
+	{
+		for (double bpm : {60.0, 120.0, 137.3, 0.0})
+		{
+			char tempo[16] = "changes";
+			if (bpm > 0.0)
+				snprintf(tempo, sizeof(tempo), "%.1f", bpm);
+			const double drift = tickDrift(sampleRate, bpm, DRIFT_HOURS);
+			printf("%7g %8s %7.3f%s\n", sampleRate, tempo, drift, drift <= 1.0 ? "" : " DRIFTS");
+			failed |= drift > 1.0;
+		}
+	}
+	printf("\n");
+
+	printf("SMF take write\n");
+	printf("%-9s %9s %10s %10s\n", "writer", "events", "write ms", "file kB");
+	static const size_t TAKE_EVENTS = 1000000;
+	ChunkedArena<TakeEvent> take;
+	take.setChunkSize(TAKE_EVENTS);
+	fillTake(take, TAKE_EVENTS);
+	{
+		auto start = Clock::now();
+		bool success = writeWithMidifile("build/bench/midifile.mid", take);
+		double elapsed = seconds(start, Clock::now());
+		printf("%-9s %9zu %10.1f %10ld%s\n", "midifile", take.size(), elapsed * 1e3, fileSize("build/bench/midifile.mid") / 1000, success ? "" : " failed");
+	}
+	{
+		SmfTakeEncoder encoder;
+		auto start = Clock::now();
+		bool success = encoder.write("build/bench/encoder.mid", take, 960);
+		double elapsed = seconds(start, Clock::now());
+		printf("%-9s %9zu %10.1f %10ld%s\n", "encoder", take.size(), elapsed * 1e3, fileSize("build/bench/encoder.mid") / 1000, success ? "" : " failed");
+	}
+	const bool same = readBack("build/bench/midifile.mid") == readBack("build/bench/encoder.mid");
+	printf("midifile reads back %s events\n", same ? "the same" : "DIFFERENT");
+	const bool matches = readSmf("build/bench/encoder.mid") == expectedTracks(take);
+	printf("encoder's file reads back %s the take\n\n", matches ? "as" : "DIFFERENT from");
+	failed |= !same || !matches;
+
+	printf("peak memory %ld kB\n", peakMemoryKb());
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+// Stand in for Rack's osdialog, see rack.hpp
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef struct osdialog_filters osdialog_filters;
+typedef enum { OSDIALOG_OPEN, OSDIALOG_OPEN_DIR, OSDIALOG_SAVE } osdialog_file_action;
+osdialog_filters *osdialog_filters_parse(const char *);
+void osdialog_filters_free(osdialog_filters *);
+char *osdialog_file(osdialog_file_action, const char *, const char *, osdialog_filters *);
+#ifdef __cplusplus
+}
+#endif
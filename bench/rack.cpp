@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////////
+//  Beyond Help Module Collection
+//  for VCV Rack By Juriel Garcia Sanchez
+//
+//  Definitions for the bench stub of the Rack API, see rack.hpp
+//
+//  See ./LICENSE.md for all licenses
+////////////////////////////////////////////////////////////////////////
+
+#include "rack.hpp"
+#include "osdialog.h"
+#include <cstdarg>
+#include <map>
+
+// Just enough of jansson for dataFromJson()
+struct json_t
+{
+	std::map<std::string, json_t *> object;
+	long long integer = 0;
+	double real = 0.0;
+	bool boolean = false;
+	std::string string;
+};
+
+json_t *json_object() { return new json_t; }
+json_t *json_integer(long long value)
+{
+	json_t *json = new json_t;
+	json->integer = value;
+	json->real = value;
+	json->boolean = value != 0;
+	return json;
+}
+json_t *json_real(double value)
+{
+	json_t *json = new json_t;
+	json->integer = (long long)value;
+	json->real = value;
+	return json;
+}
+json_t *json_boolean(bool value)
+{
+	json_t *json = new json_t;
+	json->integer = value;
+	json->boolean = value;
+	return json;
+}
+json_t *json_string(const char *value)
+{
+	json_t *json = new json_t;
+	json->string = value;
+	return json;
+}
+int json_object_set_new(json_t *object, const char *key, json_t *value)
+{
+	object->object[key] = value;
+	return 0;
+}
+json_t *json_object_get(const json_t *object, const char *key)
+{
+	auto it = object->object.find(key);
+	return it == object->object.end() ? NULL : it->second;
+}
+long long json_integer_value(const json_t *json) { return json->integer; }
+double json_real_value(const json_t *json) { return json->real; }
+double json_number_value(const json_t *json) { return json->real; }
+bool json_boolean_value(const json_t *json) { return json->boolean; }
+bool json_is_true(const json_t *json) { return json->boolean; }
+const char *json_string_value(const json_t *json) { return json->string.c_str(); }
+
+namespace rack
+{
+
+namespace random
+{
+uint32_t u32() { return ::rand(); }
+float uniform() { return ::rand() / (float)RAND_MAX; }
+} // namespace random
+
+namespace string
+{
+std::string f(const char *format, ...)
+{
+	char buffer[1024];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	return buffer;
+}
+std::string directory(const std::string &path)
+{
+	size_t i = path.rfind('/');
+	return i == std::string::npos ? "." : path.substr(0, i);
+}
+std::string filename(const std::string &path)
+{
+	size_t i = path.rfind('/');
+	return i == std::string::npos ? path : path.substr(i + 1);
+}
+std::string filenameBase(const std::string &filename)
+{
+	size_t i = filename.rfind('.');
+	return i == std::string::npos ? filename : filename.substr(0, i);
+}
+std::string filenameExtension(const std::string &filename)
+{
+	size_t i = filename.rfind('.');
+	return i == std::string::npos ? "" : filename.substr(i + 1);
+}
+std::string ellipsizePrefix(const std::string &s, size_t) { return s; }
+} // namespace string
+
+namespace system
+{
+bool isDirectory(const std::string &) { return true; }
+bool isFile(const std::string &) { return true; }
+double getTime() { return 0.0; }
+} // namespace system
+
+namespace color
+{
+NVGcolor fromHexString(std::string) { return NVGcolor{0.f, 0.f, 0.f, 1.f}; }
+} // namespace color
+
+namespace asset
+{
+std::string plugin(plugin::Plugin *plugin, const std::string &filename) { return plugin->path + "/" + filename; }
+std::string user(const std::string &filename) { return "user/" + filename; }
+std::string system(const std::string &filename) { return "./" + filename; }
+} // namespace asset
+
+static window::Window appWindow;
+static Context context{&appWindow, NULL};
+Context *contextGet() { return &context; }
+
+} // namespace rack
+
+extern "C"
+{
+osdialog_filters *osdialog_filters_parse(const char *) { return NULL; }
+void osdialog_filters_free(osdialog_filters *) {}
+char *osdialog_file(osdialog_file_action, const char *, const char *, osdialog_filters *) { return NULL; }
+}
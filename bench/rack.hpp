@@ -0,0 +1,508 @@
+//////////////////////////////////////////////////////////////////////////
+//  Beyond Help Module Collection
+//  for VCV Rack By Juriel Garcia Sanchez
+//
+//  Minimal stand in for the parts of the Rack v1 API the modules use,
+//  so `make bench` can run them headless without the SDK.
+//  Only the engine side behaves, widgets and NanoVG are no-ops.
+//
+//  See ./LICENSE.md for all licenses
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <pmmintrin.h>
+
+typedef struct json_t json_t;
+json_t *json_object();
+json_t *json_integer(long long);
+json_t *json_real(double);
+json_t *json_boolean(bool);
+json_t *json_string(const char *);
+int json_object_set_new(json_t *, const char *, json_t *);
+json_t *json_object_get(const json_t *, const char *);
+long long json_integer_value(const json_t *);
+double json_real_value(const json_t *);
+double json_number_value(const json_t *);
+bool json_boolean_value(const json_t *);
+const char *json_string_value(const json_t *);
+bool json_is_true(const json_t *);
+
+struct NVGcolor { float r, g, b, a; };
+struct NVGpaint { float f[20]; };
+struct NVGcontext;
+inline NVGcolor nvgRGBAf(float r, float g, float b, float a) { return NVGcolor{r, g, b, a}; }
+inline NVGcolor nvgTransRGBAf(NVGcolor c, float a) { c.a = a; return c; }
+inline NVGpaint nvgLinearGradient(NVGcontext *, float, float, float, float, NVGcolor, NVGcolor) { return NVGpaint(); }
+inline void nvgFontSize(NVGcontext *, float) {}
+inline void nvgFontFaceId(NVGcontext *, int) {}
+inline void nvgFillColor(NVGcontext *, NVGcolor) {}
+inline void nvgStrokeColor(NVGcontext *, NVGcolor) {}
+inline void nvgStrokePaint(NVGcontext *, NVGpaint) {}
+inline void nvgFillPaint(NVGcontext *, NVGpaint) {}
+inline void nvgStrokeWidth(NVGcontext *, float) {}
+inline void nvgBeginPath(NVGcontext *) {}
+inline void nvgMoveTo(NVGcontext *, float, float) {}
+inline void nvgLineTo(NVGcontext *, float, float) {}
+inline void nvgRect(NVGcontext *, float, float, float, float) {}
+inline void nvgCircle(NVGcontext *, float, float, float) {}
+inline void nvgStroke(NVGcontext *) {}
+inline void nvgFill(NVGcontext *) {}
+inline void nvgSave(NVGcontext *) {}
+inline void nvgRestore(NVGcontext *) {}
+inline void nvgScissor(NVGcontext *, float, float, float, float) {}
+inline void nvgTranslate(NVGcontext *, float, float) {}
+inline float nvgText(NVGcontext *, float, float, const char *, const char *) { return 0; }
+
+#define DEFER(code) do {} while (0)
+#define CHECKMARK_STRING "✔"
+#define RIGHT_ARROW "▸"
+
+namespace rack {
+
+namespace simd {
+template <typename T, int N> struct Vector;
+template <> struct Vector<int32_t, 4>;
+template <> struct Vector<float, 4> {
+	union { __m128 v; float s[4]; };
+	Vector() = default;
+	Vector(__m128 v) : v(v) {}
+	Vector(float x) { v = _mm_set1_ps(x); }
+	Vector(float a, float b, float c, float d) { v = _mm_setr_ps(a, b, c, d); }
+	inline Vector(Vector<int32_t, 4> a);
+	static Vector zero() { return Vector(_mm_setzero_ps()); }
+	static Vector mask() { return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	static Vector load(const float *x) { return Vector(_mm_loadu_ps(x)); }
+	void store(float *x) { _mm_storeu_ps(x, v); }
+	float &operator[](int i) { return s[i]; }
+	const float &operator[](int i) const { return s[i]; }
+	static Vector cast(Vector<int32_t, 4> a);
+};
+template <> struct Vector<int32_t, 4> {
+	union { __m128i v; int32_t s[4]; };
+	Vector() = default;
+	Vector(__m128i v) : v(v) {}
+	Vector(int32_t x) { v = _mm_set1_epi32(x); }
+	Vector(int32_t a, int32_t b, int32_t c, int32_t d) { v = _mm_setr_epi32(a, b, c, d); }
+	Vector(Vector<float, 4> a) { v = _mm_cvttps_epi32(a.v); }
+	static Vector zero() { return Vector(_mm_setzero_si128()); }
+	static Vector mask() { return Vector(_mm_set1_epi32(-1)); }
+	static Vector load(const int32_t *x) { return Vector(_mm_loadu_si128((const __m128i *)x)); }
+	void store(int32_t *x) { _mm_storeu_si128((__m128i *)x, v); }
+	int32_t &operator[](int i) { return s[i]; }
+	const int32_t &operator[](int i) const { return s[i]; }
+	static Vector cast(Vector<float, 4> a) { return Vector(_mm_castps_si128(a.v)); }
+};
+inline Vector<float, 4>::Vector(Vector<int32_t, 4> a) { v = _mm_cvtepi32_ps(a.v); }
+inline Vector<float, 4> Vector<float, 4>::cast(Vector<int32_t, 4> a) { return Vector(_mm_castsi128_ps(a.v)); }
+typedef Vector<float, 4> float_4;
+typedef Vector<int32_t, 4> int32_4;
+
+#define F4OP(op, f) \
+	inline float_4 operator op(const float_4 &a, const float_4 &b) { return float_4(f(a.v, b.v)); } \
+	inline float_4 &operator op##=(float_4 &a, const float_4 &b) { return a = a op b; }
+F4OP(+, _mm_add_ps) F4OP(-, _mm_sub_ps) F4OP(*, _mm_mul_ps) F4OP(/, _mm_div_ps)
+F4OP(&, _mm_and_ps) F4OP(|, _mm_or_ps) F4OP(^, _mm_xor_ps)
+#undef F4OP
+inline float_4 operator==(const float_4 &a, const float_4 &b) { return float_4(_mm_cmpeq_ps(a.v, b.v)); }
+inline float_4 operator!=(const float_4 &a, const float_4 &b) { return float_4(_mm_cmpneq_ps(a.v, b.v)); }
+inline float_4 operator<(const float_4 &a, const float_4 &b) { return float_4(_mm_cmplt_ps(a.v, b.v)); }
+inline float_4 operator>(const float_4 &a, const float_4 &b) { return float_4(_mm_cmpgt_ps(a.v, b.v)); }
+inline float_4 operator<=(const float_4 &a, const float_4 &b) { return float_4(_mm_cmple_ps(a.v, b.v)); }
+inline float_4 operator>=(const float_4 &a, const float_4 &b) { return float_4(_mm_cmpge_ps(a.v, b.v)); }
+inline float_4 operator-(const float_4 &a) { return float_4(0.f) - a; }
+inline float_4 operator~(const float_4 &a) { return a ^ float_4::mask(); }
+#define I4OP(op, f) \
+	inline int32_4 operator op(const int32_4 &a, const int32_4 &b) { return int32_4(f(a.v, b.v)); } \
+	inline int32_4 &operator op##=(int32_4 &a, const int32_4 &b) { return a = a op b; }
+I4OP(+, _mm_add_epi32) I4OP(-, _mm_sub_epi32) I4OP(&, _mm_and_si128) I4OP(|, _mm_or_si128) I4OP(^, _mm_xor_si128)
+#undef I4OP
+inline int32_4 operator<<(const int32_4 &a, const int &b) { return int32_4(_mm_slli_epi32(a.v, b)); }
+inline int32_4 operator>>(const int32_4 &a, const int &b) { return int32_4(_mm_srai_epi32(a.v, b)); }
+inline int32_4 operator==(const int32_4 &a, const int32_4 &b) { return int32_4(_mm_cmpeq_epi32(a.v, b.v)); }
+inline int32_4 operator~(const int32_4 &a) { return a ^ int32_4::mask(); }
+
+inline float_4 ifelse(float_4 m, float_4 a, float_4 b) { return (m & a) | float_4(_mm_andnot_ps(m.v, b.v)); }
+inline float ifelse(bool m, float a, float b) { return m ? a : b; }
+inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+inline float_4 fmax(float_4 a, float_4 b) { return float_4(_mm_max_ps(a.v, b.v)); }
+inline float_4 fmin(float_4 a, float_4 b) { return float_4(_mm_min_ps(a.v, b.v)); }
+inline float_4 sqrt(float_4 a) { return float_4(_mm_sqrt_ps(a.v)); }
+// sin, cos and exp the way Rack has them, sse_mathfun's Cephes polynomials, so the curves cost what they do in Rack
+inline float_4 exp(float_4 x) {
+	x = fmin(fmax(x, -88.3762626647949f), 88.3762626647949f);
+	const float_4 fx = x * 1.44269504088896341f + 0.5f;
+	float_4 n = float_4(int32_4(fx));
+	n = n - ((n > fx) & 1.f);
+	x = x - n * 0.693359375f + n * 2.12194440e-4f;
+	const float_4 z = x * x;
+	float_4 y = 1.9875691500e-4f;
+	y = y * x + 1.3981999507e-3f;
+	y = y * x + 8.3334519073e-3f;
+	y = y * x + 4.1665795894e-2f;
+	y = y * x + 1.6666665459e-1f;
+	y = y * x + 5.0000001201e-1f;
+	y = y * z + x + 1.f;
+	return y * float_4::cast((int32_4(n) + 127) << 23);
+}
+inline float_4 sin(float_4 x) {
+	const float_4 signBit = float_4::cast(int32_4(1) << 31);
+	const float_4 sign = x & signBit;
+	x = x ^ sign;
+	const int32_4 j = (int32_4(x * 1.27323954473516f) + 1) & int32_4(~1);
+	const float_4 y = float_4(j);
+	const float_4 swapSign = float_4::cast((j & 4) << 29);
+	const float_4 polyMask = float_4::cast((j & 2) == int32_4(0));
+	x = x - y * 0.78515625f - y * 2.4187564849853515625e-4f - y * 3.77489497744594108e-8f;
+	const float_4 z = x * x;
+	float_4 c = 2.443315711809948e-5f;
+	c = c * z - 1.388731625493765e-3f;
+	c = c * z + 4.166664568298827e-2f;
+	c = c * z * z - z * 0.5f + 1.f;
+	float_4 s = -1.9515295891e-4f;
+	s = s * z + 8.3321608736e-3f;
+	s = s * z - 1.6666654611e-1f;
+	s = s * z * x + x;
+	return ifelse(polyMask, s, c) ^ sign ^ swapSign;
+}
+inline float_4 cos(float_4 x) { return sin(x + 1.57079632679489662f); }
+// Scalar per lane, slower than the SSE versions in Rack
+#define F4FN(fn) inline float_4 fn(float_4 a) { return float_4(std::fn(a[0]), std::fn(a[1]), std::fn(a[2]), std::fn(a[3])); }
+F4FN(log) F4FN(floor) F4FN(trunc) F4FN(fabs) F4FN(round) F4FN(log2)
+#undef F4FN
+inline float_4 pow(float_4 a, float_4 b) { return exp(b * log(a)); }
+inline float_4 pow(float a, float_4 b) { return exp(b * std::log(a)); }
+inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+inline float_4 crossfade(float_4 a, float_4 b, float_4 p) { return a + (b - a) * p; }
+inline float_4 rescale(float_4 x, float_4 xMin, float_4 xMax, float_4 yMin, float_4 yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+} // namespace simd
+
+namespace math {
+inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+inline float clamp(float x, float a = 0.f, float b = 1.f) { return std::fmax(std::fmin(x, b), a); }
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+inline float crossfade(float a, float b, float p) { return a + (b - a) * p; }
+inline int eucMod(int a, int b) { int m = a % b; return m < 0 ? m + b : m; }
+struct Vec {
+	float x = 0, y = 0;
+	Vec() {}
+	Vec(float x, float y) : x(x), y(y) {}
+	Vec mult(float s) const { return Vec(x * s, y * s); }
+	Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+	Vec minus(Vec b) const { return Vec(x - b.x, y - b.y); }
+};
+struct Rect {
+	Vec pos, size;
+	Rect() {}
+	Rect(Vec p, Vec s) : pos(p), size(s) {}
+	Rect(float x, float y, float w, float h) : pos(x, y), size(w, h) {}
+};
+} // namespace math
+using namespace math;
+
+namespace random { uint32_t u32(); float uniform(); }
+namespace string {
+std::string f(const char *fmt, ...);
+std::string directory(const std::string &);
+std::string filename(const std::string &);
+std::string filenameBase(const std::string &);
+std::string filenameExtension(const std::string &);
+std::string ellipsizePrefix(const std::string &, size_t);
+} // namespace string
+namespace system {
+bool isDirectory(const std::string &);
+bool isFile(const std::string &);
+double getTime();
+} // namespace system
+namespace color { NVGcolor fromHexString(std::string); }
+
+namespace dsp {
+template <typename T = float> struct TSchmittTrigger {
+	T state;
+	TSchmittTrigger() { reset(); }
+	void reset() { state = T::mask(); }
+	T process(T in) {
+		T on = (in >= 1.f);
+		T off = (in <= 0.f);
+		T triggered = ~state & on;
+		state = on | (state & ~off);
+		return triggered;
+	}
+};
+template <> struct TSchmittTrigger<float> {
+	bool state = true;
+	void reset() { state = true; }
+	bool process(float in) {
+		if (state) { if (in <= 0.f) state = false; }
+		else if (in >= 1.f) { state = true; return true; }
+		return false;
+	}
+	bool isHigh() { return state; }
+};
+typedef TSchmittTrigger<> SchmittTrigger;
+struct BooleanTrigger {
+	bool state = true;
+	void reset() { state = true; }
+	bool process(bool s) { bool t = s && !state; state = s; return t; }
+};
+struct ClockDivider {
+	uint32_t clock = 0, division = 1;
+	void reset() { clock = 0; }
+	void setDivision(uint32_t d) { division = d; }
+	uint32_t getDivision() { return division; }
+	uint32_t getClock() { return clock; }
+	bool process() { if (++clock >= division) { clock = 0; return true; } return false; }
+};
+struct PulseGenerator {
+	float remaining = 0.f;
+	void reset() { remaining = 0.f; }
+	bool process(float dt) { if (remaining > 0.f) { remaining -= dt; return true; } return false; }
+	void trigger(float d = 1e-3f) { if (d > remaining) remaining = d; }
+};
+} // namespace dsp
+
+namespace engine {
+static const int PORT_MAX_CHANNELS = 16;
+struct Param {
+	float value = 0.f;
+	float getValue() { return value; }
+	void setValue(float v) { value = v; }
+};
+struct Port {
+	float voltages[PORT_MAX_CHANNELS] = {};
+	uint8_t channels = 0;
+	void setVoltage(float v, int c = 0) { voltages[c] = v; }
+	float getVoltage(int c = 0) { return voltages[c]; }
+	float getPolyVoltage(int c) { return isMonophonic() ? getVoltage(0) : getVoltage(c); }
+	float getNormalVoltage(float n, int c = 0) { return isConnected() ? getVoltage(c) : n; }
+	float getNormalPolyVoltage(float n, int c) { return isConnected() ? getPolyVoltage(c) : n; }
+	float *getVoltages(int c = 0) { return &voltages[c]; }
+	template <typename T> T getVoltageSimd(int c) { return T::load(&voltages[c]); }
+	template <typename T> T getPolyVoltageSimd(int c) { return isMonophonic() ? T(getVoltage(0)) : getVoltageSimd<T>(c); }
+	template <typename T> T getNormalPolyVoltageSimd(T n, int c) { return isConnected() ? getPolyVoltageSimd<T>(c) : n; }
+	template <typename T> void setVoltageSimd(T v, int c) { v.store(&voltages[c]); }
+	void setChannels(int c) { if (channels == 0) return; if (c == 0) c = 1; channels = c; }
+	int getChannels() { return channels; }
+	bool isConnected() { return channels > 0; }
+	bool isMonophonic() { return channels == 1; }
+	bool isPolyphonic() { return channels > 1; }
+};
+struct Output : Port {};
+struct Input : Port {};
+struct Light { float value = 0.f; void setBrightness(float b) { value = b; } void setSmoothBrightness(float, float) {} };
+struct Module;
+struct ParamQuantity {
+	Module *module = NULL;
+	int paramId = 0;
+	float minValue = 0.f, maxValue = 1.f, defaultValue = 0.f;
+	std::string label, unit;
+	float displayBase = 0.f, displayMultiplier = 1.f, displayOffset = 0.f;
+	bool snapEnabled = false;
+	virtual ~ParamQuantity() {}
+	virtual void setValue(float v);
+	virtual float getValue();
+	virtual float getDisplayValue() { return getValue(); }
+	virtual void setDisplayValue(float v) { setValue(v); }
+	virtual std::string getDisplayValueString() { return string::f("%g", getDisplayValue()); }
+	virtual std::string getLabel() { return label; }
+	virtual std::string getUnit() { return unit; }
+};
+} // namespace engine
+
+namespace plugin { struct Model; struct Plugin { std::string path = "plugins/BeyondHelp"; void addModel(Model *) {} }; }
+
+namespace engine {
+struct Module {
+	plugin::Model *model = NULL;
+	int id = -1;
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	std::vector<ParamQuantity *> paramQuantities;
+	struct Expander {
+		int moduleId = -1;
+		Module *module = NULL;
+		void *producerMessage = NULL;
+		void *consumerMessage = NULL;
+		bool messageFlipRequested = false;
+	};
+	Expander leftExpander, rightExpander;
+	struct ProcessArgs { float sampleRate; float sampleTime; };
+	virtual ~Module() {}
+	void config(int p, int i, int o, int l = 0) {
+		params.resize(p); inputs.resize(i); outputs.resize(o); lights.resize(l); paramQuantities.resize(p);
+	}
+	template <class TParamQuantity = ParamQuantity>
+	void configParam(int id, float minValue, float maxValue, float defaultValue, std::string label = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+		ParamQuantity *q = new TParamQuantity;
+		q->module = this; q->paramId = id; q->minValue = minValue; q->maxValue = maxValue; q->defaultValue = defaultValue;
+		q->label = label; q->unit = unit;
+		paramQuantities[id] = q;
+		params[id].value = defaultValue;
+	}
+	virtual void process(const ProcessArgs &args) {}
+	virtual json_t *dataToJson() { return NULL; }
+	virtual void dataFromJson(json_t *root) {}
+	virtual void onAdd() {}
+	virtual void onRemove() {}
+	virtual void onReset() {}
+	virtual void onRandomize() {}
+	virtual void onSampleRateChange() {}
+};
+inline void ParamQuantity::setValue(float v) { module->params[paramId].setValue(v); }
+inline float ParamQuantity::getValue() { return module->params[paramId].getValue(); }
+} // namespace engine
+
+struct Svg { int handle = 0; };
+struct Font { int handle = 0; };
+namespace window {
+// Cached by path like Rack's, so repeat loads cost a map lookup
+struct Window {
+	std::map<std::string, std::weak_ptr<Font>> fontCache;
+	std::map<std::string, std::weak_ptr<Svg>> svgCache;
+	std::shared_ptr<Font> loadFont(const std::string &filename) { return load(fontCache, filename); }
+	std::shared_ptr<Svg> loadSvg(const std::string &filename) { return load(svgCache, filename); }
+	template <typename T>
+	static std::shared_ptr<T> load(std::map<std::string, std::weak_ptr<T>> &cache, const std::string &filename) {
+		std::shared_ptr<T> sp = cache[filename].lock();
+		if (!sp)
+			cache[filename] = sp = std::make_shared<T>();
+		return sp;
+	}
+};
+} // namespace window
+struct Context { window::Window *window; engine::Module *engine; };
+Context *contextGet();
+#define APP rack::contextGet()
+
+namespace asset {
+std::string plugin(plugin::Plugin *, const std::string &);
+std::string user(const std::string &);
+std::string system(const std::string &);
+} // namespace asset
+
+namespace event { struct Action {}; struct Change {}; struct Hover {}; struct Button {}; }
+
+namespace widget {
+struct Widget {
+	Rect box;
+	Widget *parent = NULL;
+	std::vector<Widget *> children;
+	bool visible = true;
+	struct DrawArgs { NVGcontext *vg = NULL; Rect clipBox; void *fb = NULL; };
+	virtual ~Widget() { for (Widget *child : children) delete child; }
+	void addChild(Widget *w) { children.push_back(w); w->parent = this; }
+	virtual void step() {}
+	virtual void draw(const DrawArgs &args) {}
+	virtual void onAction(const event::Action &) {}
+};
+struct TransparentWidget : Widget {};
+struct OpaqueWidget : Widget {};
+struct FramebufferWidget : Widget {
+	bool dirty = true;
+	bool bypassed = false;
+	float oversample = 1.f;
+	void setDirty(bool d = true) { dirty = d; }
+};
+} // namespace widget
+using namespace widget;
+
+namespace ui {
+struct MenuEntry : OpaqueWidget {};
+struct MenuItem : MenuEntry {
+	std::string text, rightText;
+	bool disabled = false;
+	void step() override {}
+	virtual Widget *createChildMenu() { return NULL; }
+};
+struct MenuSeparator : MenuEntry {};
+struct MenuLabel : MenuEntry { std::string text; };
+struct Menu : OpaqueWidget {};
+} // namespace ui
+using namespace ui;
+
+namespace app {
+struct ModuleWidget : OpaqueWidget {
+	plugin::Model *model = NULL;
+	engine::Module *module = NULL;
+	~ModuleWidget() { delete module; }
+	void setModule(engine::Module *m) { module = m; }
+	void setPanel(std::shared_ptr<Svg>) {}
+	void addParam(Widget *w) { addChild(w); }
+	void addInput(Widget *w) { addChild(w); }
+	void addOutput(Widget *w) { addChild(w); }
+	virtual void appendContextMenu(Menu *menu) {}
+};
+struct ParamWidget : OpaqueWidget { engine::ParamQuantity *paramQuantity = NULL; };
+struct PortWidget : OpaqueWidget { engine::Module *module = NULL; int portId = 0; };
+struct SvgSwitch : ParamWidget {
+	bool momentary = false;
+	widget::FramebufferWidget *fb = NULL;
+	std::vector<std::shared_ptr<Svg>> frames;
+	void addFrame(std::shared_ptr<Svg> s) { frames.push_back(s); }
+};
+struct SvgKnob : ParamWidget {
+	float minAngle = -M_PI, maxAngle = M_PI;
+	void setSvg(std::shared_ptr<Svg>) {}
+};
+struct SvgPort : PortWidget { void setSvg(std::shared_ptr<Svg>) {} };
+} // namespace app
+using namespace app;
+struct PJ301MPort : app::SvgPort {
+	PJ301MPort() { setSvg(APP->window->loadSvg(asset::system("res/ComponentLibrary/PJ301M.svg"))); }
+};
+
+namespace plugin {
+struct Model {
+	std::string slug;
+	virtual ~Model() {}
+	virtual engine::Module *createModule() = 0;
+	virtual app::ModuleWidget *createModuleWidget() = 0;
+};
+} // namespace plugin
+
+template <class TModule, class TModuleWidget>
+plugin::Model *createModel(std::string slug) {
+	struct TModel : plugin::Model {
+		engine::Module *createModule() override { TModule *m = new TModule; m->model = this; return m; }
+		app::ModuleWidget *createModuleWidget() override {
+			TModule *m = new TModule; m->model = this;
+			TModuleWidget *mw = new TModuleWidget(m); mw->model = this; return mw;
+		}
+	};
+	plugin::Model *o = new TModel; o->slug = slug; return o;
+}
+template <class TWidget> TWidget *createWidget(math::Vec pos) { TWidget *o = new TWidget; o->box.pos = pos; return o; }
+template <class TWidget> TWidget *createWidgetCentered(math::Vec pos) { TWidget *o = new TWidget; o->box.pos = pos; return o; }
+template <class TParamWidget> TParamWidget *createParamCentered(math::Vec pos, engine::Module *m, int id) { TParamWidget *o = new TParamWidget; o->box.pos = pos; return o; }
+template <class TPortWidget> TPortWidget *createInputCentered(math::Vec pos, engine::Module *m, int id) { TPortWidget *o = new TPortWidget; o->box.pos = pos; o->module = m; o->portId = id; return o; }
+template <class TPortWidget> TPortWidget *createOutputCentered(math::Vec pos, engine::Module *m, int id) { TPortWidget *o = new TPortWidget; o->box.pos = pos; o->module = m; o->portId = id; return o; }
+inline ui::MenuLabel *createMenuLabel(std::string text) { ui::MenuLabel *o = new ui::MenuLabel; o->text = text; return o; }
+inline math::Vec mm2px(math::Vec mm) { return mm.mult(75.f / 25.4f); }
+
+template <typename T> T *construct() { return new T; }
+template <typename T, typename F, typename V, typename... Args>
+T *construct(F f, V v, Args... args) { T *o = construct<T>(args...); o->*f = v; return o; }
+
+using namespace engine;
+using plugin::Plugin;
+using plugin::Model;
+} // namespace rack
+
+// Plugin entry point, as declared by Rack
+extern "C" void init(rack::plugin::Plugin *plugin);
@@ -1,14 +1,70 @@
-#include "MidiFile.h"
 #include "plugin.hpp"
+#include "smfencoder.hpp"
+#include "tensionbus.hpp"
+#include "penners.hpp"
 #include <osdialog.h>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 
 static const char *MIDI_FILTER = "Midi (.mid):mid";
 static constexpr int MAX_CHANNEL_SIZE = 16;
+static constexpr uint16_t TICKS_PER_QN = 960;
+
+// Samples between gate reads
+static const int GATE_DIVISIONS[] = {1, 4, 16, 32, 64};
+static constexpr int GATE_DIVISION_COUNT = sizeof(GATE_DIVISIONS) / sizeof(GATE_DIVISIONS[0]);
+
+// Sizes the take's storage, one chunk holds a minute of events at this rate
+static const int EVENTS_PER_MINUTE[] = {1000, 10000, 100000};
+static constexpr int EVENTS_PER_MINUTE_COUNT = sizeof(EVENTS_PER_MINUTE) / sizeof(EVENTS_PER_MINUTE[0]);
+
+// MIDI note at 0 V
+static const int REFERENCE_NOTES[] = {48, 60, 72};
+static const char *REFERENCE_NOTE_NAMES[] = {"C3", "C4", "C5"};
+static constexpr int REFERENCE_NOTE_COUNT = sizeof(REFERENCE_NOTES) / sizeof(REFERENCE_NOTES[0]);
+
+// What a pitch change under a held gate records
+enum PitchChange
+{
+	PITCH_HOLD,
+	PITCH_RETRIGGER,
+	PITCH_LEGATO,
+	PITCH_BEND,
+	PITCH_CHANGE_COUNT
+};
+static const char *PITCH_CHANGE_NAMES[] = {"Hold the note", "Retrigger", "Legato", "Pitch bend"};
+
+static constexpr float NOTE_HYSTERESIS = 0.2f; // Semitones past the halfway point before the note changes
+static constexpr float BEND_RANGE = 2.f;	   // Semitones, the General MIDI default
+static constexpr float BEND_STEP = 1.f / 64;   // Smallest bend change recorded, about 3 cents
+
+static constexpr int RETROSPECTIVE_MINUTES = 10; // History saved by retrospective capture
+
+// Controllers recorded from the CC input
+static const int AUTOMATION_CONTROLLERS[] = {1, 2, 11, 74};
+static const char *AUTOMATION_CONTROLLER_NAMES[] = {"Mod wheel", "Breath", "Expression", "Brightness"};
+static constexpr int AUTOMATION_CONTROLLER_COUNT = sizeof(AUTOMATION_CONTROLLERS) / sizeof(AUTOMATION_CONTROLLERS[0]);
+
+// CC steps a simplified lane may stray from what was recorded, 0 keeps every step
+static const float AUTOMATION_TOLERANCES[] = {0.f, 1.f, 2.f, 4.f, 8.f};
+static constexpr int AUTOMATION_TOLERANCE_COUNT = sizeof(AUTOMATION_TOLERANCES) / sizeof(AUTOMATION_TOLERANCES[0]);
+
+static constexpr int AUTOMATION_DIVISION = 64;		 // Samples between CC input reads
+static constexpr float AUTOMATION_DEADBAND = 0.5f; // CC steps, smaller changes can't show in 7 bits
+
+// Changes to a Tension curve midway through a run that are worth a marker
+static constexpr float SEGMENT_SHAPE_STEP = 1.f / 16;
+static constexpr float SEGMENT_DURATION_STEP = 0.01f; // Relative to the run's duration
 
 static std::string HexStringToByteString(std::string hex)
 {
@@ -26,14 +82,759 @@ static std::string HexStringToByteString(std::string hex)
 	return result;
 }
 
-static uint8_t voltPerOctToMidi(float voltage)
+/// 1 V/oct, 0 V is the reference note. Sticks to the held note until the pitch is clearly past it,
+/// a new note (held of -1) is just the nearest
+static uint8_t voltPerOctToMidi(float voltage, int reference, int held = -1)
 {
-	return 0;
+	const float semitones = reference + voltage * 12.f;
+	if (held >= 0 && std::fabs(semitones - held) < 0.5f + NOTE_HYSTERESIS)
+		return held;
+	return clamp((int)std::round(semitones), 0, 127);
 }
 
+/// 0 V ... 10 V, never 0 since a NoteOn with no velocity is a NoteOff
 static uint8_t voltVelToMidi(float voltage)
 {
-	return 0;
+	return clamp((int)std::round(voltage * 12.7f), 1, 127);
+}
+
+/// Fixed size event pushed by the engine thread, never allocates
+struct MidiCaptureEvent
+{
+	enum Type : uint8_t
+	{
+		NOTE_ON,
+		NOTE_OFF,
+		PITCH_BEND,	 // value is the bend, -1 ... 1
+		CONTROL,	 // note is the controller, value is in CC steps, 0 ... 127
+		SEGMENT,	 // A Tension curve started or changed, value is the duration, note the shape in 16ths, velocity the phase in 255ths
+		TEMPO,		 // value is the tempo in BPM
+		SAMPLE_RATE, // value is the new sample rate
+		START,		 // Begins a take, value is the sample rate
+		STOP,		 // Ends a take, which is then written
+		SAVE_HISTORY // Writes a retrospective ring, in track, value is the sample rate and bpm the tempo
+	};
+
+	uint64_t frame; // Samples since the take's first note
+	float value;
+	uint8_t type;
+	uint8_t track;
+	uint8_t channel;
+	uint8_t note;
+	uint8_t velocity;
+	uint8_t flags; // SEGMENT_* for segments
+	float bpm;	   // SAVE_HISTORY only, fills what would be padding
+};
+static_assert(sizeof(MidiCaptureEvent) == 24, "MidiCaptureEvent should pack into 24 bytes, the writer's queue is sized on it");
+
+enum SegmentFlags
+{
+	SEGMENT_MODE = 0x03, // Ease::Mode
+	SEGMENT_FALLING = 0x04,
+	SEGMENT_RESTARTED = 0x08
+};
+
+/// Appends events to a format 0 Standard MIDI File as they arrive, so memory stays constant
+/// however long the take. Every flush ends the track and patches its MTrk length, in an order
+/// that leaves a playable file after each write, so a crash at any point loses at most one flush.
+struct MidiFileStream
+{
+	~MidiFileStream() { close(); }
+
+	bool open(const std::string &path, uint16_t ticksPerQN)
+	{
+		close();
+		file = std::fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		trackLength = 0;
+		encoder.reset();
+
+		const uint8_t header[] = {
+			'M', 'T', 'h', 'd', 0, 0, 0, 6,
+			0, 0, // Format 0
+			0, 1, // One track
+			uint8_t(ticksPerQN >> 8), uint8_t(ticksPerQN & 0xFF),
+			'M', 'T', 'r', 'k', 0, 0, 0, 0, // Length, patched on flush
+		};
+		return std::fwrite(header, sizeof(header), 1, file) == 1 && flush();
+	}
+
+	bool isOpen() const { return file != NULL; }
+
+	/// Ticks must not go backwards
+	void addEvent(uint32_t tick, uint8_t status, uint8_t data1, uint8_t data2) { encoder.addEvent(tick, status, data1, data2); }
+	void addTempo(uint32_t tick, uint32_t microsecondsPerQN) { encoder.addTempo(tick, microsecondsPerQN); }
+	void addMarker(uint32_t tick, const std::string &text) { encoder.addMarker(tick, text); }
+
+	/// Appends the buffered events and a new end of track past the old one, takes them into the
+	/// track length, then turns the old end of track into an empty text event
+	bool flush()
+	{
+		if (!file)
+			return false;
+
+		std::vector<uint8_t> &buffer = encoder.bytes;
+		if (buffer.empty() && trackLength > 0)
+			return std::fflush(file) == 0;
+
+		// Past the declared length, so readers don't see it yet
+		const uint8_t endOfTrack[] = {0x00, 0xFF, 0x2F, 0x00};
+		bool success = std::fseek(file, TRACK_START + trackLength, SEEK_SET) == 0;
+		if (!buffer.empty())
+			success &= std::fwrite(buffer.data(), buffer.size(), 1, file) == 1;
+		success &= std::fwrite(endOfTrack, sizeof(endOfTrack), 1, file) == 1;
+		success &= std::fflush(file) == 0;
+
+		// Readers stop at the old end of track until it's replaced
+		const uint32_t oldLength = trackLength;
+		trackLength += buffer.size() + sizeof(endOfTrack);
+		encoder.clearWritten();
+		const uint8_t lengthBytes[] = {uint8_t(trackLength >> 24), uint8_t(trackLength >> 16), uint8_t(trackLength >> 8), uint8_t(trackLength)};
+		success &= std::fseek(file, TRACK_START - 4, SEEK_SET) == 0;
+		success &= std::fwrite(lengthBytes, sizeof(lengthBytes), 1, file) == 1;
+		success &= std::fflush(file) == 0;
+
+		if (oldLength > 0)
+		{
+			const uint8_t text = 0x01;
+			success &= std::fseek(file, TRACK_START + oldLength - 2, SEEK_SET) == 0;
+			success &= std::fwrite(&text, 1, 1, file) == 1;
+			success &= std::fflush(file) == 0;
+		}
+		return success;
+	}
+
+	bool close()
+	{
+		if (!file)
+			return false;
+		bool success = flush();
+		success &= syncFile(file);
+		success &= std::fclose(file) == 0;
+		file = NULL;
+		return success;
+	}
+
+private:
+	static constexpr long TRACK_START = 22; // MThd chunk + MTrk tag and length
+
+	std::FILE *file = NULL;
+	SmfTrackEncoder encoder;  // Events since the last flush
+	uint32_t trackLength = 0; // Bytes on disk, up to and including the last end of track
+};
+
+/// What was played while not recording, so a performance can still be saved after the fact.
+/// The engine fills one ring while the writer saves the other, each holds the latest CAPACITY events.
+/// That's an event count, not a time: a dense performance fills a ring well before RETROSPECTIVE_MINUTES
+struct RetrospectiveBuffer
+{
+	// ~0.8 MB per ring, 10 minutes only below about 50 events a second
+	static constexpr size_t CAPACITY = 1 << 15;
+
+	MidiCaptureEvent rings[2][CAPACITY];
+	size_t counts[2] = {};		// Events pushed since the ring was started, engine thread until handed over
+	std::atomic<bool> saving[2]; // Set by the engine when it hands a ring over, cleared by the writer
+	int current = 0;			// Ring being filled, engine thread only
+
+	RetrospectiveBuffer()
+	{
+		saving[0].store(false);
+		saving[1].store(false);
+	}
+
+	/// Engine thread. Overwrites the oldest event once the ring is full
+	void push(const MidiCaptureEvent &event)
+	{
+		rings[current][counts[current]++ % CAPACITY] = event;
+	}
+};
+
+struct MidiFileWriter;
+
+/// One thread writes for every recorder, so a large patch doesn't pay a thread per instance.
+/// It sleeps until woken while every recorder is idle, and only polls while a take is running.
+/// UI thread for everything but run()
+struct MidiWriterThread
+{
+	static MidiWriterThread &get()
+	{
+		static MidiWriterThread instance;
+		return instance;
+	}
+
+	~MidiWriterThread() { stop(); }
+
+	void add(MidiFileWriter *writer)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		writers.push_back(writer);
+		if (!thread.joinable())
+		{
+			running = true;
+			thread = std::thread(&MidiWriterThread::run, this);
+		}
+	}
+
+	/// Returns once the thread is done with the writer, stopping it with the last one
+	void remove(MidiFileWriter *writer)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			serviced.wait(lock, [&] { return servicing != writer; });
+			writers.erase(std::find(writers.begin(), writers.end(), writer));
+			if (!writers.empty())
+				return;
+		}
+		stop();
+	}
+
+	void wake()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			woken = true;
+		}
+		cv.notify_one();
+	}
+
+private:
+	std::thread thread;
+	std::mutex mutex; // Never held through file I/O
+	std::condition_variable cv, serviced;
+	std::vector<MidiFileWriter *> writers;
+	MidiFileWriter *servicing = NULL;
+	bool running = false;
+	bool woken = false;
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+		cv.notify_one();
+		if (thread.joinable())
+			thread.join();
+	}
+
+	void run();
+};
+
+/// Drains captured events into a compact take, then encodes and writes finished takes
+/// on the shared writer thread, away from the engine
+struct MidiFileWriter
+{
+	enum Status
+	{
+		IDLE,
+		WRITING,
+		DONE,
+		FAILED
+	};
+
+	// 24 byte events, ~1.5 MB. Seconds of dense 16 channel playing with controllers, drained every 20 ms
+	static constexpr size_t QUEUE_SIZE = 1 << 16;
+
+	MidiFileWriter()
+	{
+		MidiWriterThread::get().add(this);
+	}
+
+	/// Writes what the engine left in the queue, a take it stopped included, on the calling thread
+	~MidiFileWriter()
+	{
+		MidiWriterThread::get().remove(this);
+		service();
+		stream.close();
+	}
+
+	/// Engine thread. Counts the event as an overflow when the queue is full
+	bool push(const MidiCaptureEvent &event)
+	{
+		if (!queue.push(event))
+		{
+			overflows.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		// Waking the thread is a system call, so the engine only raises a flag for wake() to pass on
+		if (event.type == MidiCaptureEvent::START || event.type == MidiCaptureEvent::STOP || event.type == MidiCaptureEvent::SAVE_HISTORY)
+			signalled.store(true, std::memory_order_release);
+		return true;
+	}
+
+	/// UI thread, every frame. Wakes the writer thread if the engine started, stopped or saved a take
+	void wake()
+	{
+		if (signalled.load(std::memory_order_acquire) && signalled.exchange(false))
+			MidiWriterThread::get().wake();
+	}
+
+	/// Writer thread, or the destructor once the thread has let go. Returns whether a take is running,
+	/// for the thread to keep polling the queue
+	bool service()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			settings = shared;
+			if (pathChanged)
+				incrementIndex = 0;
+			pathChanged = false;
+		}
+
+		drain();
+
+		if (stream.isOpen() && std::chrono::steady_clock::now() - lastFlushTime >= std::chrono::seconds(1))
+		{
+			if (!stream.flush())
+				status.store(FAILED);
+			lastFlushTime = std::chrono::steady_clock::now();
+		}
+		return taking || stream.isOpen();
+	}
+
+	/// UI thread. Allocated on first use and kept until the writer goes, so the engine can hold on to it
+	RetrospectiveBuffer *getHistory()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!history)
+			history.reset(new RetrospectiveBuffer);
+		return history.get();
+	}
+
+	/// UI thread
+	void setPath(const std::string &path, bool shouldIncrementPath)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (shared.path != path)
+			pathChanged = true;
+		shared.path = path;
+		shared.shouldIncrementPath = shouldIncrementPath;
+	}
+
+	/// UI thread. The last file written, or attempted
+	std::string getLastPath()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return lastPath;
+	}
+
+	/// UI thread. Applies from the next take
+	void setExpectedEventsPerMinute(int expectedEventsPerMinute)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shared.expectedEventsPerMinute = expectedEventsPerMinute;
+	}
+
+	/// UI thread. Applies when a take is written
+	void setAutomationTolerance(float automationTolerance)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shared.automationTolerance = automationTolerance;
+	}
+
+	/// UI thread. Applies from the next take
+	void setStreaming(bool streaming)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shared.streaming = streaming;
+	}
+
+	Status getStatus() const { return status.load(); }
+	uint32_t getOverflows() const { return overflows.load(); }
+
+private:
+	// What the UI sets, copied by the writer before each drain
+	struct Settings
+	{
+		std::string path;
+		bool shouldIncrementPath = true;
+		bool streaming = false;
+		int expectedEventsPerMinute = 10000;
+		float automationTolerance = 1.f;
+	};
+
+	std::mutex mutex; // Held only to copy settings and paths, never through file I/O
+	Settings shared;  // Under the mutex, as are the three below
+	bool pathChanged = false;
+	std::string lastPath;
+	std::unique_ptr<RetrospectiveBuffer> history;
+
+	SpscRingBuffer<MidiCaptureEvent, QUEUE_SIZE> queue;
+	std::atomic<uint32_t> overflows{0};
+	std::atomic<Status> status{IDLE};
+	std::atomic<bool> signalled{false};
+
+	Settings settings;		 // writer thread only, from here down
+	int incrementIndex = 0;
+	bool taking = false; // Between START and STOP
+
+	ChunkedArena<TakeEvent> take; // writer thread only
+	SmfTakeEncoder encoder;		  // writer thread only
+	TickClock tickClock{TICKS_PER_QN}; // writer thread only
+	MidiFileStream stream;	// writer thread only, open while streaming a take
+
+	// Controller lanes collect points per voice until the take ends, then are simplified into automation
+	struct AutomationLane
+	{
+		std::vector<ControlPoint> points;
+		uint8_t status;
+		uint8_t track;
+		uint8_t controller;
+	};
+	AutomationLane lanes[MAX_CHANNEL_SIZE]; // writer thread only
+	std::vector<TakeEvent> automation;	  // writer thread only, in time order once simplified
+	AutomationSimplifier simplifier;		  // writer thread only
+	std::vector<std::string> markers;		  // writer thread only, texts of the take's MARKER events
+	std::chrono::steady_clock::time_point lastFlushTime;
+
+	void setLastPath(const std::string &path)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		lastPath = path;
+	}
+
+	void drain()
+	{
+		MidiCaptureEvent event;
+		while (queue.shift(event))
+		{
+			switch (event.type)
+			{
+			case MidiCaptureEvent::NOTE_ON:
+			case MidiCaptureEvent::NOTE_OFF:
+				addNote(event);
+				break;
+			case MidiCaptureEvent::PITCH_BEND:
+				addPitchBend(event);
+				break;
+			case MidiCaptureEvent::CONTROL:
+				addControl(event);
+				break;
+			case MidiCaptureEvent::SEGMENT:
+				addSegment(event);
+				break;
+			case MidiCaptureEvent::TEMPO:
+				addTempo(event);
+				break;
+			case MidiCaptureEvent::SAMPLE_RATE:
+				tickClock.setSampleRate(event.frame, event.value);
+				break;
+			case MidiCaptureEvent::START:
+				clearTake();
+				take.setChunkSize(settings.expectedEventsPerMinute);
+				take.reserve(settings.expectedEventsPerMinute);
+				tickClock.reset(event.value);
+				taking = true;
+				if (settings.streaming)
+					openStream();
+				break;
+			case MidiCaptureEvent::STOP:
+				if (stream.isOpen())
+				{
+					closeStream();
+				}
+				else
+				{
+					finishAutomation();
+					write();
+				}
+				clearTake();
+				taking = false;
+				break;
+			case MidiCaptureEvent::SAVE_HISTORY:
+				saveHistory(event);
+				break;
+			}
+		}
+	}
+
+	/// Writes the last RETROSPECTIVE_MINUTES of a ring the engine handed over, from the first note,
+	/// or fewer when the ring has already dropped older events
+	/// in that window, then hands the ring back
+	void saveHistory(const MidiCaptureEvent &save)
+	{
+		RetrospectiveBuffer *history;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			history = this->history.get();
+		}
+
+		const size_t capacity = RetrospectiveBuffer::CAPACITY;
+		const int ring = save.track;
+		const MidiCaptureEvent *events = history->rings[ring];
+		const size_t end = history->counts[ring];
+		const size_t oldest = end > capacity ? end - capacity : 0;
+
+		const uint64_t window = uint64_t(RETROSPECTIVE_MINUTES * 60 * double(save.value));
+		const uint64_t since = save.frame > window ? save.frame - window : 0;
+
+		// Tempo and sample rate in effect at the first note. Once the ring has wrapped the
+		// events that set them may be gone, so start from what they were when it was saved
+		float sampleRate = save.value;
+		float bpm = save.bpm;
+		size_t first = oldest;
+		for (; first < end; first++)
+		{
+			const MidiCaptureEvent &event = events[first % capacity];
+			if (event.type == MidiCaptureEvent::NOTE_ON && event.frame >= since)
+				break;
+			if (event.type == MidiCaptureEvent::TEMPO)
+				bpm = event.value;
+			else if (event.type == MidiCaptureEvent::SAMPLE_RATE)
+				sampleRate = event.value;
+		}
+
+		if (first < end)
+		{
+			const uint64_t origin = events[first % capacity].frame;
+
+			clearTake();
+			take.setChunkSize(settings.expectedEventsPerMinute);
+			tickClock.reset(sampleRate);
+
+			MidiCaptureEvent tempo = {};
+			tempo.value = bpm;
+			addTempo(tempo);
+
+			// NoteOffs whose NoteOn fell out of the window are dropped
+			bool held[MAX_CHANNEL_SIZE][128] = {};
+			for (size_t i = first; i < end; i++)
+			{
+				MidiCaptureEvent event = events[i % capacity];
+				event.frame -= origin;
+
+				bool &isHeld = held[event.channel % MAX_CHANNEL_SIZE][event.note & 0x7F];
+				switch (event.type)
+				{
+				case MidiCaptureEvent::NOTE_ON:
+					isHeld = true;
+					addNote(event);
+					break;
+				case MidiCaptureEvent::NOTE_OFF:
+					if (isHeld)
+						addNote(event);
+					isHeld = false;
+					break;
+				case MidiCaptureEvent::PITCH_BEND:
+					addPitchBend(event);
+					break;
+				case MidiCaptureEvent::CONTROL:
+					addControl(event);
+					break;
+				case MidiCaptureEvent::SEGMENT:
+					addSegment(event);
+					break;
+				case MidiCaptureEvent::TEMPO:
+					addTempo(event);
+					break;
+				case MidiCaptureEvent::SAMPLE_RATE:
+					tickClock.setSampleRate(event.frame, event.value);
+					break;
+				}
+			}
+
+			finishAutomation();
+			write();
+			clearTake();
+		}
+
+		history->saving[ring].store(false, std::memory_order_release);
+	}
+
+	void addTempo(const MidiCaptureEvent &event)
+	{
+		const uint32_t tick = tickClock.toTick(event.frame);
+		const uint32_t microsecondsPerQN = tickClock.setTempo(event.frame, event.value);
+		if (stream.isOpen())
+			stream.addTempo(tick, microsecondsPerQN);
+		else
+			take.push(TakeEvent{tick, TakeEvent::TEMPO, {uint8_t(microsecondsPerQN >> 16), uint8_t(microsecondsPerQN >> 8), uint8_t(microsecondsPerQN)}});
+	}
+
+	void addNote(const MidiCaptureEvent &event)
+	{
+		if (stream.isOpen())
+		{
+			// A streamed file is a single track, voices stay apart on their channels
+			const uint8_t status = (event.type == MidiCaptureEvent::NOTE_ON ? 0x90 : 0x80) | (event.channel & 0x0F);
+			stream.addEvent(tickClock.toTick(event.frame), status, event.note, event.velocity);
+			return;
+		}
+
+		const uint8_t status = (event.type == MidiCaptureEvent::NOTE_ON ? 0x90 : 0x80) | event.channel;
+		take.push(TakeEvent{tickClock.toTick(event.frame), status, {event.track, event.note, event.velocity}});
+	}
+
+	void addPitchBend(const MidiCaptureEvent &event)
+	{
+		const int bend = clamp((int)std::round((event.value + 1.f) * 8192.f), 0, 16383);
+		if (stream.isOpen())
+		{
+			stream.addEvent(tickClock.toTick(event.frame), 0xE0 | (event.channel & 0x0F), bend & 0x7F, bend >> 7);
+			return;
+		}
+
+		const uint8_t status = 0xE0 | event.channel;
+		take.push(TakeEvent{tickClock.toTick(event.frame), status, {event.track, uint8_t(bend & 0x7F), uint8_t(bend >> 7)}});
+	}
+
+	void addControl(const MidiCaptureEvent &event)
+	{
+		const uint32_t tick = tickClock.toTick(event.frame);
+		if (stream.isOpen())
+		{
+			// Streamed lanes can't be simplified, they keep what the deadband let through
+			const int value = clamp((int)std::round(event.value), 0, 127);
+			stream.addEvent(tick, 0xB0 | (event.channel & 0x0F), event.note, value);
+			return;
+		}
+
+		AutomationLane &lane = lanes[event.channel % MAX_CHANNEL_SIZE];
+		const uint8_t status = 0xB0 | event.channel;
+		if (!lane.points.empty() && (lane.controller != event.note || lane.status != status || lane.track != event.track))
+			simplifyLane(lane);
+
+		lane.status = status;
+		lane.track = event.track;
+		lane.controller = event.note;
+		lane.points.push_back(ControlPoint{tick, event.value});
+	}
+
+	void simplifyLane(AutomationLane &lane)
+	{
+		simplifier.simplify(lane.points, settings.automationTolerance, lane.status, lane.track, lane.controller, automation);
+		lane.points.clear();
+	}
+
+	/// Simplifies what is left in the lanes, then puts all of it in time order for the encoder
+	void finishAutomation()
+	{
+		for (int i = 0; i < MAX_CHANNEL_SIZE; i++)
+			simplifyLane(lanes[i]);
+
+		std::stable_sort(automation.begin(), automation.end(), [](const TakeEvent &a, const TakeEvent &b) {
+			return a.tick < b.tick;
+		});
+	}
+
+	/// A marker describing the segment, e.g. "Tension 1 fall, Sine Both, 0.500 s a run, from 25%"
+	void addSegment(const MidiCaptureEvent &event)
+	{
+		const float shape = event.note / 16.f;
+		const int lower = std::min((int)shape, Ease::COUNT - 1);
+		const int amount = (int)std::round((shape - lower) * 100.f);
+		std::string text = string::f("Tension %d %s, %s", event.channel + 1, (event.flags & SEGMENT_FALLING) ? "fall" : "rise", Ease::TypeStrings[lower]);
+		if (amount > 0 && lower < Ease::COUNT - 1)
+			text += string::f(" to %s %d%%", Ease::TypeStrings[lower + 1], amount);
+		text += string::f(" %s, %.3f s a run, %s %d%%", Ease::ModeStrings[std::min(event.flags & SEGMENT_MODE, 2)], event.value,
+						  (event.flags & SEGMENT_RESTARTED) ? "from" : "at", (int)std::round(event.velocity * 100.f / 255.f));
+
+		const uint32_t tick = tickClock.toTick(event.frame);
+		if (stream.isOpen())
+		{
+			stream.addMarker(tick, text);
+			return;
+		}
+
+		const uint32_t index = markers.size();
+		markers.push_back(text);
+		take.push(TakeEvent{tick, TakeEvent::MARKER, {uint8_t(index >> 16), uint8_t(index >> 8), uint8_t(index)}});
+	}
+
+	void clearTake()
+	{
+		take.clear();
+		for (int i = 0; i < MAX_CHANNEL_SIZE; i++)
+			lanes[i].points.clear();
+		automation.clear();
+		markers.clear();
+	}
+
+	std::string nextPath() const
+	{
+		return settings.shouldIncrementPath ? settings.path + string::f(".%03d", incrementIndex) + ".mid" : settings.path + ".mid";
+	}
+
+	void openStream()
+	{
+		if (settings.path == "")
+		{
+			status.store(IDLE);
+			return;
+		}
+
+		const std::string streamPath = nextPath();
+		setLastPath(streamPath);
+		status.store(stream.open(streamPath, TICKS_PER_QN) ? WRITING : FAILED);
+		lastFlushTime = std::chrono::steady_clock::now();
+	}
+
+	void closeStream()
+	{
+		if (stream.close())
+		{
+			if (settings.shouldIncrementPath)
+				incrementIndex++;
+			status.store(DONE);
+		}
+		else
+		{
+			status.store(FAILED);
+		}
+	}
+
+	void write()
+	{
+		if (settings.path == "")
+		{
+			status.store(IDLE);
+			return;
+		}
+
+		const std::string writePath = nextPath();
+		setLastPath(writePath);
+		status.store(WRITING);
+
+		if (encoder.write(writePath, take, TICKS_PER_QN, automation, markers))
+		{
+			if (settings.shouldIncrementPath)
+				incrementIndex++;
+			status.store(DONE);
+		}
+		else
+		{
+			status.store(FAILED);
+		}
+	}
+};
+
+void MidiWriterThread::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	bool polling = false;
+	while (running)
+	{
+		// Takes in progress are drained every 20 ms, otherwise only a wake() gets the thread going
+		if (polling)
+			cv.wait_for(lock, std::chrono::milliseconds(20), [&] { return woken || !running; });
+		else
+			cv.wait(lock, [&] { return woken || !running; });
+		woken = false;
+
+		polling = false;
+		for (size_t i = 0; i < writers.size(); i++)
+		{
+			servicing = writers[i];
+			lock.unlock();
+			polling |= servicing->service();
+			lock.lock();
+			servicing = NULL;
+			serviced.notify_all();
+		}
+	}
 }
 
 struct TenseMidiRecorder : Module
@@ -50,6 +851,7 @@ struct TenseMidiRecorder : Module
 		VOLTAGE_INPUT,
 		GATE_INPUT,
 		VELOCITY_INPUT,
+		CC_INPUT,
 		NUM_INPUTS
 	};
 	enum OutputIds
@@ -67,34 +869,48 @@ private:
 	std::string basename;
 
 	bool shouldIncrementPath;
-	bool isRecording;
+	bool isRecording = false;
 	bool polyphonyAsDistinctTracks;
-	bool isClockConnected;
-	bool firstClockReceived;
-	bool secondClockReceived;
-	bool firstEventReceived;
+	bool streamToDisk;
+	bool retrospective;
+	bool isClockConnected = false;
+	bool firstEventReceived = false;
 
-	float bpm;
-	float timeElapsed;
-	float duration;
+	float bpm = 120;
 
 	int incrementIndex;
-	int clockMode;
+	int clockMode = ClockMode::CLOCK;
+	int gateDivision = 16;
+	int referenceNote = 60;
+	int pitchChange = PITCH_HOLD;
+	int expectedEventsPerMinute = 10000;
+	int automationController = 1;
+	float automationTolerance = 1.f;
+
+	// Recording clock, in samples since the take's first note. Converted to ticks by the writer
+	uint64_t frame = 0;
+	float recordedBpm = 0.f;
+	float recordedSampleRate = 0.f;
 
-	uint16_t ticksPerQN = 960;
+	std::vector<bool> prevGates;
+	uint8_t prevNotes[MAX_CHANNEL_SIZE] = {}; // Held notes, so NoteOff matches its NoteOn
+	float prevBends[MAX_CHANNEL_SIZE] = {};	  // Last bend recorded per channel
+	float prevControls[MAX_CHANNEL_SIZE] = {}; // Last controller value recorded per channel, negative for none yet
+	TensionVoice prevSegments[MAX_CHANNEL_SIZE] = {}; // Tension's curves as last recorded, mode is negative for none yet
 
-	long totalTime;
-	int tickCount;
-	long ticksSinceLastEvent;
-	double stepCount;
+	// Expander messages from a Tension on the left, double buffered by the engine
+	TensionBusMessage tensionMessages[2];
 
-	std::vector<bool> prevGates;
+	dsp::ClockDivider clockDivider, gateDivider, automationDivider;
+	dsp::SchmittTrigger trigTrigger;
+	ClockTracker<float> clockTracker;
+	bool recordArmed = false; // Record button as last read, it latches
 
-	dsp::ClockDivider clockDivider;
-	dsp::SchmittTrigger clockTrigger, trigTrigger;
-	dsp::BooleanTrigger recTrigger;
+	MidiFileWriter writer;
 
-	smf::MidiFile midiFile;
+	// Set from the UI thread while retrospective capture is on, the engine follows at control rate
+	std::atomic<RetrospectiveBuffer *> history{NULL};
+	RetrospectiveBuffer *capturing = NULL; // Engine thread
 
 	friend struct TenseMidiRecorderWidget;
 
@@ -107,12 +923,24 @@ public:
 		configParam(TRIGGER_PARAM, 0.f, 1.f, 0.f, "");
 
 		clockDivider.setDivision(32);
+		gateDivider.setDivision(gateDivision);
+		automationDivider.setDivision(AUTOMATION_DIVISION);
 
 		prevGates.resize(MAX_CHANNEL_SIZE, false);
 
+		leftExpander.producerMessage = &tensionMessages[0];
+		leftExpander.consumerMessage = &tensionMessages[1];
+
 		onReset();
 	}
 
+	~TenseMidiRecorder()
+	{
+		// Submit the take in progress, the writer drains its queue before its thread goes
+		if (isRecording)
+			stop();
+	}
+
 	json_t *dataToJson() override
 	{
 		json_t *json = json_object();
@@ -120,6 +948,14 @@ public:
 		json_object_set_new(json, "path", json_string(path.c_str()));
 		json_object_set_new(json, "shouldIncrementPath", json_boolean(shouldIncrementPath));
 		json_object_set_new(json, "polyphonyAsDistinctTracks", json_boolean(polyphonyAsDistinctTracks));
+		json_object_set_new(json, "gateDivision", json_integer(gateDivision));
+		json_object_set_new(json, "streamToDisk", json_boolean(streamToDisk));
+		json_object_set_new(json, "referenceNote", json_integer(referenceNote));
+		json_object_set_new(json, "pitchChange", json_integer(pitchChange));
+		json_object_set_new(json, "expectedEventsPerMinute", json_integer(expectedEventsPerMinute));
+		json_object_set_new(json, "retrospective", json_boolean(retrospective));
+		json_object_set_new(json, "automationController", json_integer(automationController));
+		json_object_set_new(json, "automationTolerance", json_real(automationTolerance));
 
 		return json;
 	}
@@ -132,11 +968,46 @@ public:
 
 		json_t *shouldIncrementPathDef = json_object_get(json, "shouldIncrementPath");
 		if (shouldIncrementPathDef)
-			shouldIncrementPath = json_boolean_value(shouldIncrementPathDef);
+			setShouldIncrementPath(json_boolean_value(shouldIncrementPathDef));
 
 		json_t *polyphonyAsDistinctTracksDef = json_object_get(json, "polyphonyAsDistinctTracks");
 		if (polyphonyAsDistinctTracksDef)
 			polyphonyAsDistinctTracks = json_boolean_value(polyphonyAsDistinctTracksDef);
+
+		json_t *streamToDiskDef = json_object_get(json, "streamToDisk");
+		if (streamToDiskDef)
+			setStreamToDisk(json_boolean_value(streamToDiskDef));
+
+		json_t *gateDivisionDef = json_object_get(json, "gateDivision");
+		if (gateDivisionDef)
+			setGateDivision(json_integer_value(gateDivisionDef));
+
+		json_t *referenceNoteDef = json_object_get(json, "referenceNote");
+		if (referenceNoteDef)
+			referenceNote = clamp((int)json_integer_value(referenceNoteDef), 0, 127);
+
+		json_t *pitchChangeDef = json_object_get(json, "pitchChange");
+		if (pitchChangeDef)
+			pitchChange = clamp((int)json_integer_value(pitchChangeDef), 0, PITCH_CHANGE_COUNT - 1);
+
+		json_t *expectedEventsPerMinuteDef = json_object_get(json, "expectedEventsPerMinute");
+		if (expectedEventsPerMinuteDef)
+			setExpectedEventsPerMinute(json_integer_value(expectedEventsPerMinuteDef));
+
+		json_t *retrospectiveDef = json_object_get(json, "retrospective");
+		if (retrospectiveDef)
+			setRetrospective(json_boolean_value(retrospectiveDef));
+
+		json_t *automationControllerDef = json_object_get(json, "automationController");
+		if (automationControllerDef)
+			automationController = clamp((int)json_integer_value(automationControllerDef), 0, 127);
+
+		json_t *automationToleranceDef = json_object_get(json, "automationTolerance");
+		if (automationToleranceDef)
+			setAutomationTolerance(json_number_value(automationToleranceDef));
+
+		// Params are loaded first, a patch saved mid-take doesn't start recording on load
+		params[TRIGGER_PARAM].setValue(0.f);
 	}
 
 	void onReset() override
@@ -146,107 +1017,141 @@ public:
 		basename = "";
 		shouldIncrementPath = true;
 		polyphonyAsDistinctTracks = false;
+		referenceNote = 60;
+		pitchChange = PITCH_HOLD;
 		incrementIndex = 0;
+		writer.setPath(path, shouldIncrementPath);
+		setStreamToDisk(false);
+		setExpectedEventsPerMinute(10000);
+		setRetrospective(false);
+		automationController = 1;
+		setAutomationTolerance(1.f);
 	}
 
 	void process(const ProcessArgs &args) override
 	{
 		float sampleRate = args.sampleRate;
-		timeElapsed += 1.0 / args.sampleRate;
 
 		// Clock Pin
 		if (inputs[CLOCK_INPUT].isConnected())
 		{
-			if (ClockMode::BPM)
+			if (clockMode == ClockMode::BPM)
 			{
-				bpm = powf(1.0, clamp(inputs[CLOCK_INPUT].getVoltage(), -10.0f, 10.0f)) * 120.0;
-				duration = 60.0 / bpm;
+				// 0 V = 120 BPM, 1 V/oct
+				bpm = powf(2.0, clamp(inputs[CLOCK_INPUT].getVoltage(), -10.0f, 10.0f)) * 120.0;
 			}
 			else
 			{
-				if (clockTrigger.process(inputs[CLOCK_INPUT].getVoltage()))
-				{
-					if (firstClockReceived)
-					{
-						duration = timeElapsed;
-						secondClockReceived = true;
-					}
-					timeElapsed = 0;
-					firstClockReceived = true;
-				}
-				else if (secondClockReceived && timeElapsed > duration)
-				{
-					duration = timeElapsed;
-				}
-				bpm = duration * bpm;
+				// One clock per quarter note, the last tempo holds while the clock is stopped
+				clockTracker.process(inputs[CLOCK_INPUT].getVoltage(), args.sampleTime);
+				if (clockTracker.locked)
+					bpm = 60.f / clockTracker.period;
 			}
 			isClockConnected = true;
 		}
 		else
 		{
 			bpm = 120;
-			duration = 60 / bpm;
-			firstClockReceived = false;
-			secondClockReceived = false;
+			clockTracker.reset();
 			isClockConnected = false;
 		}
 
 		if (clockDivider.process())
 		{
-			bool _isRecording = isRecording;
+			// The button latches, recording follows its level and the trigger toggles it
+			const bool armed = params[TRIGGER_PARAM].getValue() > 0.f;
+			const bool pressed = armed != recordArmed;
+			recordArmed = armed;
+			const bool triggered = trigTrigger.process(rescale(inputs[RECORD_INPUT].getVoltage(), 0.1, 2.0, 0.0, 1.0));
+
+			RetrospectiveBuffer *_history = history.load(std::memory_order_acquire);
+			if (_history != capturing)
+			{
+				if (isRecording)
+					stop();
+				if (_history)
+					startCapture(_history, sampleRate);
+				else
+					capturing = NULL;
+			}
 
-			if (recTrigger.process(params[TRIGGER_PARAM].getValue()))
-				_isRecording ^= true;
-			if (trigTrigger.process(rescale(inputs[RECORD_INPUT].getVoltage(), 0.1, 2.0, 0.0, 1.0)))
-				_isRecording ^= true;
+			if (capturing)
+			{
+				// Capture never stops, either button edge or a trigger saves what it holds
+				if (pressed || triggered)
+					saveHistory(sampleRate);
+			}
+			else
+			{
+				bool _isRecording = isRecording;
+				if (pressed)
+					_isRecording = armed;
+				if (triggered)
+					_isRecording ^= true;
+
+				if (_isRecording && !isRecording)
+					start(sampleRate);
+				else if (!_isRecording && isRecording)
+					stop();
+
+				// Show takes the trigger started or stopped on the button
+				if (armed != isRecording)
+				{
+					params[TRIGGER_PARAM].setValue(isRecording ? 1.f : 0.f);
+					recordArmed = isRecording;
+				}
+			}
 
-			if (!_isRecording && isRecording)
-				stop();
+			if (isRecording || capturing)
+				updateTempo(sampleRate);
 		}
 
-		float tickLength = (sampleRate * 60) / (bpm * ticksPerQN);
-
-		if (isRecording)
+		if (isRecording || capturing)
 		{
-			uint8_t numChannels = inputs[GATE_INPUT].getChannels();
-
-			for (int i = 0; i < numChannels; i++)
+			// Only gate edges produce events, sampled at control rate
+			if (gateDivider.process())
 			{
-				int gateIn = inputs[GATE_INPUT].getVoltage(i);
-				float noteIn = inputs[VOLTAGE_INPUT].getVoltage(i);
-				float velocityIn = inputs[VOLTAGE_INPUT].getVoltage(i);
+				const int numChannels = inputs[GATE_INPUT].getChannels();
 
-				if (gateIn && !prevGates[i])
-				{
-					if (polyphonyAsDistinctTracks)
-						midiFile.addNoteOn(i, ticksSinceLastEvent, 0, voltPerOctToMidi(noteIn), voltVelToMidi(velocityIn));
-					else
-						midiFile.addNoteOn(0, ticksSinceLastEvent, i, voltPerOctToMidi(noteIn), voltVelToMidi(velocityIn));
-				}
-				else
+				for (int i = 0; i < MAX_CHANNEL_SIZE; i++)
 				{
-					if (polyphonyAsDistinctTracks)
-						midiFile.addNoteOff(i, ticksSinceLastEvent, 0, voltPerOctToMidi(noteIn), voltVelToMidi(velocityIn));
-					else
-						midiFile.addNoteOff(0, ticksSinceLastEvent, i, voltPerOctToMidi(noteIn), voltVelToMidi(velocityIn));
-				}
-			}
+					// Channels that went away release their notes
+					const bool gateIn = i < numChannels && inputs[GATE_INPUT].getVoltage(i) >= 1.f;
+					if (gateIn == prevGates[i])
+					{
+						if (gateIn && pitchChange != PITCH_HOLD)
+							processHeldPitch(i);
+						continue;
+					}
+					prevGates[i] = gateIn;
 
-			if (firstEventReceived)
-			{
-				stepCount++;
-				if (stepCount >= tickLength)
-				{
-					stepCount -= tickLength;
-					ticksSinceLastEvent++;
-					tickCount++;
-					if (tickCount >= ticksPerQN)
+					if (gateIn)
+					{
+						const float noteIn = inputs[VOLTAGE_INPUT].getPolyVoltage(i);
+						const float velocityIn = inputs[VELOCITY_INPUT].getNormalPolyVoltage(10.f, i);
+
+						prevNotes[i] = voltPerOctToMidi(noteIn, referenceNote);
+						receiveEvent();
+						if (pitchChange == PITCH_BEND)
+							pushBend(i, noteIn, true);
+						pushNoteEvent(MidiCaptureEvent::NOTE_ON, i, prevNotes[i], voltVelToMidi(velocityIn));
+					}
+					else
 					{
-						totalTime++;
-						tickCount = 0;
+						pushNoteEvent(MidiCaptureEvent::NOTE_OFF, i, prevNotes[i], 0);
 					}
 				}
 			}
+
+			if (leftExpander.module && leftExpander.module->model == modelTension)
+				processSegments(static_cast<TensionBusMessage *>(leftExpander.consumerMessage));
+
+			// Controller lanes start with the take's first note
+			if (automationDivider.process() && (firstEventReceived || capturing))
+				processAutomation();
+
+			if (firstEventReceived || capturing)
+				frame++;
 		}
 	}
 
@@ -260,13 +1165,21 @@ public:
 			this->path = "";
 			directory = "";
 			basename = "";
+			writer.setPath(this->path, shouldIncrementPath);
 			return;
 		}
 
 		directory = string::directory(path);
 		basename = string::filenameBase(string::filename(path));
-		path = directory + "/" + basename; // midi file extension...
+		this->path = directory + "/" + basename; // midi file extension...
 		incrementIndex = 0;
+		writer.setPath(this->path, shouldIncrementPath);
+	}
+
+	void setShouldIncrementPath(bool shouldIncrementPath)
+	{
+		this->shouldIncrementPath = shouldIncrementPath;
+		writer.setPath(path, shouldIncrementPath);
 	}
 
 	bool isPathDirectoryValid() const
@@ -276,24 +1189,285 @@ public:
 		return system::isDirectory(string::directory(path));
 	}
 
+	void setStreamToDisk(bool streamToDisk)
+	{
+		this->streamToDisk = streamToDisk;
+		writer.setStreaming(streamToDisk);
+	}
+
+	void setExpectedEventsPerMinute(int expectedEventsPerMinute)
+	{
+		this->expectedEventsPerMinute = clamp(expectedEventsPerMinute, 100, 1000000);
+		writer.setExpectedEventsPerMinute(this->expectedEventsPerMinute);
+	}
+
+	/// Allocates the buffer on first use, so instances that never capture don't pay for it
+	void setRetrospective(bool retrospective)
+	{
+		this->retrospective = retrospective;
+		history.store(retrospective ? writer.getHistory() : NULL, std::memory_order_release);
+	}
+
+	void setAutomationTolerance(float automationTolerance)
+	{
+		this->automationTolerance = clamp(automationTolerance, 0.f, 127.f);
+		writer.setAutomationTolerance(this->automationTolerance);
+	}
+
+	void setGateDivision(int gateDivision)
+	{
+		this->gateDivision = clamp(gateDivision, 1, 1024);
+		gateDivider.setDivision(this->gateDivision);
+	}
+
+	/// A voice keeps its MIDI channel either way, so its bends only move its own notes.
+	/// Distinct tracks put it on a track of its own as well
+	void setVoice(MidiCaptureEvent &event, int channel)
+	{
+		event.track = polyphonyAsDistinctTracks ? channel : 0;
+		event.channel = channel;
+	}
+
+	void pushNoteEvent(MidiCaptureEvent::Type type, int channel, uint8_t note, uint8_t velocity)
+	{
+		MidiCaptureEvent event = {};
+		event.type = type;
+		event.frame = frame;
+		event.value = 0.f;
+		setVoice(event, channel);
+		event.note = note;
+		event.velocity = velocity;
+		capture(event);
+	}
+
+	/// A held channel's pitch moved, read at the gate rate
+	void processHeldPitch(int channel)
+	{
+		const float noteIn = inputs[VOLTAGE_INPUT].getPolyVoltage(channel);
+		if (pitchChange == PITCH_BEND)
+		{
+			pushBend(channel, noteIn);
+			return;
+		}
+
+		const uint8_t note = voltPerOctToMidi(noteIn, referenceNote, prevNotes[channel]);
+		if (note == prevNotes[channel])
+			return;
+
+		// Legato overlaps the old note by starting the new one first
+		const uint8_t velocity = voltVelToMidi(inputs[VELOCITY_INPUT].getNormalPolyVoltage(10.f, channel));
+		if (pitchChange == PITCH_LEGATO)
+			pushNoteEvent(MidiCaptureEvent::NOTE_ON, channel, note, velocity);
+		pushNoteEvent(MidiCaptureEvent::NOTE_OFF, channel, prevNotes[channel], 0);
+		if (pitchChange == PITCH_RETRIGGER)
+			pushNoteEvent(MidiCaptureEvent::NOTE_ON, channel, note, velocity);
+		prevNotes[channel] = note;
+	}
+
+	/// Bends the held note towards the pitch, within the bend range. A new note always gets its own bend,
+	/// so it doesn't start from where the last one on the channel was left
+	void pushBend(int channel, float noteIn, bool noteOn = false)
+	{
+		const float bend = clamp((referenceNote + noteIn * 12.f - prevNotes[channel]) / BEND_RANGE, -1.f, 1.f);
+		if (noteOn ? bend == prevBends[channel] : std::fabs(bend - prevBends[channel]) < BEND_STEP)
+			return;
+		prevBends[channel] = bend;
+
+		MidiCaptureEvent event = {};
+		event.type = MidiCaptureEvent::PITCH_BEND;
+		event.frame = frame;
+		event.value = bend;
+		setVoice(event, channel);
+		event.note = 0;
+		event.velocity = 0;
+		capture(event);
+	}
+
+	/// The take starts at its first note or segment, with its controllers in place
+	void receiveEvent()
+	{
+		if (firstEventReceived || capturing)
+			return;
+		firstEventReceived = true;
+		processAutomation();
+	}
+
+	/// Records a segment whenever one of Tension's curves starts a run, or changes shape, mode or speed midway
+	void processSegments(TensionBusMessage *message)
+	{
+		for (int i = 0; i < message->channels; i++)
+		{
+			TensionVoice voice = message->voices[i];
+			TensionVoice &prev = prevSegments[i];
+
+			// A late clock stretches the duration every step, the run keeps the one it had until the clock is back
+			if (voice.stretching && prev.mode >= 0)
+				voice.duration = prev.duration;
+			const bool changed = voice.restarted || voice.mode != prev.mode || voice.falling != prev.falling ||
+								 std::fabs(voice.shape - prev.shape) >= SEGMENT_SHAPE_STEP ||
+								 std::fabs(voice.duration - prev.duration) > SEGMENT_DURATION_STEP * prev.duration;
+			if (!changed)
+				continue;
+			prev = voice;
+			receiveEvent();
+
+			MidiCaptureEvent event = {};
+			event.type = MidiCaptureEvent::SEGMENT;
+			event.frame = frame;
+			event.value = voice.duration;
+			event.track = 0;
+			event.channel = i;
+			event.note = (uint8_t)clamp((int)std::round(voice.shape * 16.f), 0, 255);
+			event.velocity = (uint8_t)clamp((int)std::round(voice.phase * 255.f), 0, 255);
+			event.flags = (voice.mode & SEGMENT_MODE) | (voice.falling ? SEGMENT_FALLING : 0) | (voice.restarted ? SEGMENT_RESTARTED : 0);
+			capture(event);
+		}
+
+		// Our own buffer, marked as read in case Tension stops sending
+		message->channels = 0;
+	}
+
+	/// Records each CC input channel as a controller on its voice, 0 V ... 10 V, when it moved past the deadband
+	void processAutomation()
+	{
+		const int numChannels = inputs[CC_INPUT].getChannels();
+		for (int i = 0; i < numChannels; i++)
+		{
+			const float value = clamp(inputs[CC_INPUT].getVoltage(i) * 12.7f, 0.f, 127.f);
+			if (std::fabs(value - prevControls[i]) < AUTOMATION_DEADBAND)
+				continue;
+			prevControls[i] = value;
+
+			MidiCaptureEvent event = {};
+			event.type = MidiCaptureEvent::CONTROL;
+			event.frame = frame;
+			event.value = value;
+			setVoice(event, i);
+			event.note = automationController;
+			event.velocity = 0;
+			capture(event);
+		}
+	}
+
+	void pushControlEvent(MidiCaptureEvent::Type type, float value = 0.f)
+	{
+		MidiCaptureEvent event = {};
+		event.type = type;
+		event.frame = frame;
+		event.value = value;
+		capture(event);
+	}
+
+	/// Into the retrospective buffer while capturing, otherwise to the writer
+	void capture(const MidiCaptureEvent &event)
+	{
+		if (capturing)
+			capturing->push(event);
+		else
+			writer.push(event);
+	}
+
+	/// Tempo and sample rate changes go to the writer as they happen, read at control rate
+	void updateTempo(float sampleRate)
+	{
+		if (sampleRate != recordedSampleRate)
+		{
+			recordedSampleRate = sampleRate;
+			pushControlEvent(MidiCaptureEvent::SAMPLE_RATE, sampleRate);
+		}
+
+		if (std::fabs(bpm - recordedBpm) >= 0.01f)
+		{
+			recordedBpm = bpm;
+			pushControlEvent(MidiCaptureEvent::TEMPO, bpm);
+		}
+	}
+
+	void start(float sampleRate)
+	{
+		frame = 0;
+		pushControlEvent(MidiCaptureEvent::START, sampleRate);
+		recordedSampleRate = sampleRate;
+		recordedBpm = 0.f;
+
+		isRecording = true;
+		firstEventReceived = false;
+		std::fill(prevGates.begin(), prevGates.end(), false);
+		std::fill(prevBends, prevBends + MAX_CHANNEL_SIZE, 0.f);
+		std::fill(prevControls, prevControls + MAX_CHANNEL_SIZE, -1.f);
+		for (int i = 0; i < MAX_CHANNEL_SIZE; i++)
+			prevSegments[i].mode = -1;
+	}
+
 	void stop()
 	{
+		// Release held notes so the take doesn't end with hanging notes
+		for (int i = 0; i < MAX_CHANNEL_SIZE; i++)
+		{
+			if (prevGates[i])
+				pushNoteEvent(MidiCaptureEvent::NOTE_OFF, i, prevNotes[i], 0);
+			prevGates[i] = false;
+		}
+
 		writeToMidiFile();
+		isRecording = false;
 	}
 
-	void writeToMidiFile()
+	/// Starts retrospective capture in an empty ring
+	void startCapture(RetrospectiveBuffer *history, float sampleRate)
 	{
-		if (path == "")
-			return;
+		capturing = history;
+		capturing->counts[capturing->current] = 0;
+
+		frame = 0;
+		recordedSampleRate = 0.f;
+		recordedBpm = 0.f;
+		std::fill(prevGates.begin(), prevGates.end(), false);
+		std::fill(prevBends, prevBends + MAX_CHANNEL_SIZE, 0.f);
+		std::fill(prevControls, prevControls + MAX_CHANNEL_SIZE, -1.f);
+		for (int i = 0; i < MAX_CHANNEL_SIZE; i++)
+			prevSegments[i].mode = -1;
+		updateTempo(sampleRate);
+	}
 
-		std::string incrementedPath = path + string::f(".%03d", incrementIndex) + ".mid";
+	/// Hands the ring being filled to the writer and carries on in the other one
+	void saveHistory(float sampleRate)
+	{
+		const int ring = capturing->current;
+		if (capturing->saving[1 - ring].load(std::memory_order_acquire))
+			return; // Still writing the previous one
+
+		// Held notes end where the history does
+		for (int i = 0; i < MAX_CHANNEL_SIZE; i++)
+		{
+			if (prevGates[i])
+				pushNoteEvent(MidiCaptureEvent::NOTE_OFF, i, prevNotes[i], 0);
+		}
 
-		midiFile.sortTracks();
-		if (midiFile.write(incrementedPath))
+		MidiCaptureEvent event = {};
+		event.type = MidiCaptureEvent::SAVE_HISTORY;
+		event.frame = frame;
+		event.value = sampleRate;
+		event.bpm = bpm;
+		event.track = ring;
+		capturing->saving[ring].store(true, std::memory_order_relaxed);
+		if (!writer.push(event))
 		{
-			incrementIndex++;
+			capturing->saving[ring].store(false, std::memory_order_relaxed);
+			return;
 		}
-		midiFile.clear();
+
+		capturing->current = 1 - ring;
+		capturing->counts[1 - ring] = 0;
+		recordedSampleRate = 0.f;
+		recordedBpm = 0.f;
+		updateTempo(sampleRate);
+	}
+
+	void writeToMidiFile()
+	{
+		// Encoding and writing happen on the writer thread
+		pushControlEvent(MidiCaptureEvent::STOP);
 	}
 };
 
@@ -326,11 +1500,18 @@ static void selectPath(TenseMidiRecorder *module)
 
 struct TenseMidiRecorderWidget : ModuleWidget
 {
+	void step() override
+	{
+		if (module)
+			static_cast<TenseMidiRecorder *>(module)->writer.wake();
+		ModuleWidget::step();
+	}
+
 	TenseMidiRecorderWidget(TenseMidiRecorder *module)
 	{
 		setModule(module);
 
-		setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/TenseMidiRecorder.svg")));
+		setPanel(Resources::getSvg(Resources::TENSE_MIDI_RECORDER_PANEL));
 
 		addParam(createParamCentered<TToggleButton>(mm2px(Vec(7.67, 12.0)), module, TenseMidiRecorder::TRIGGER_PARAM));
 
@@ -339,13 +1520,12 @@ struct TenseMidiRecorderWidget : ModuleWidget
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.62, 86.659)), module, TenseMidiRecorder::VOLTAGE_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.62, 101.659)), module, TenseMidiRecorder::GATE_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.62, 116.899)), module, TenseMidiRecorder::VELOCITY_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.62, 42.6)), module, TenseMidiRecorder::CC_INPUT));
 
 		// mm2px(Vec(12.192, 5.0))
 		addChild(createWidget<Widget>(mm2px(Vec(1.574, 22.15))));
 		// mm2px(Vec(12.192, 5.0))
 		addChild(createWidget<Widget>(mm2px(Vec(1.574, 31.054))));
-		// mm2px(Vec(12.192, 5.0))
-		addChild(createWidget<Widget>(mm2px(Vec(1.574, 40.075))));
 	}
 
 	void appendContextMenu(Menu *menu) override
@@ -361,9 +1541,37 @@ struct TenseMidiRecorderWidget : ModuleWidget
 		menu->addChild(construct<PathItem>(&MenuItem::text, path != "" ? path : "Select...", &TMRItem::module, module));
 		menu->addChild(construct<ShouldIncrementPathItem>(&MenuItem::text, "Append (000, 001, 002...)", &TMRItem::module, module));
 
+		std::string lastPath = string::ellipsizePrefix(module->writer.getLastPath(), 30);
+		switch (module->writer.getStatus())
+		{
+		case MidiFileWriter::WRITING:
+			menu->addChild(createMenuLabel("Writing " + lastPath + "..."));
+			break;
+		case MidiFileWriter::DONE:
+			menu->addChild(createMenuLabel("Saved " + lastPath));
+			break;
+		case MidiFileWriter::FAILED:
+			menu->addChild(createMenuLabel("Failed to write " + lastPath));
+			break;
+		case MidiFileWriter::IDLE:
+		default:
+			break;
+		}
+
+		if (module->writer.getOverflows() > 0)
+			menu->addChild(createMenuLabel(string::f("%u events dropped, queue full", module->writer.getOverflows())));
+
 		menu->addChild(new MenuSeparator);
 
 		menu->addChild(construct<PolyphonyAsDistinctTracks>(&MenuItem::text, "Polyphony as distinct tracks", &TMRItem::module, module));
+		menu->addChild(construct<StreamToDiskItem>(&MenuItem::text, "Stream to disk while recording", &TMRItem::module, module));
+		menu->addChild(construct<RetrospectiveItem>(&MenuItem::text, string::f("Always capture, record saves up to %d minutes or %d events", RETROSPECTIVE_MINUTES, int(RetrospectiveBuffer::CAPACITY)), &TMRItem::module, module));
+		menu->addChild(construct<GateDivisionMenuItem>(&MenuItem::text, "Gate sampling", &MenuItem::rightText, RIGHT_ARROW, &TMRItem::module, module));
+		menu->addChild(construct<ReferenceNoteMenuItem>(&MenuItem::text, "Note at 0 V", &MenuItem::rightText, RIGHT_ARROW, &TMRItem::module, module));
+		menu->addChild(construct<PitchChangeMenuItem>(&MenuItem::text, "Pitch change while held", &MenuItem::rightText, RIGHT_ARROW, &TMRItem::module, module));
+		menu->addChild(construct<AutomationControllerMenuItem>(&MenuItem::text, "CC input records", &MenuItem::rightText, RIGHT_ARROW, &TMRItem::module, module));
+		menu->addChild(construct<AutomationToleranceMenuItem>(&MenuItem::text, "Simplify automation", &MenuItem::rightText, RIGHT_ARROW, &TMRItem::module, module));
+		menu->addChild(construct<EventsPerMinuteMenuItem>(&MenuItem::text, "Expected events per minute", &MenuItem::rightText, RIGHT_ARROW, &TMRItem::module, module));
 
 		// TODO Some More Settings :D
 	}
@@ -395,6 +1603,154 @@ struct TenseMidiRecorderWidget : ModuleWidget
 		}
 	};
 
+	struct GateDivisionMenuItem : TMRItem
+	{
+		struct GateDivisionItem : TMRItem
+		{
+			int division;
+			void onAction(const event::Action &e) override { module->setGateDivision(division); }
+			void step() override
+			{
+				rightText = (module->gateDivision == division) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Menu *createChildMenu() override
+		{
+			Menu *menu = new Menu;
+			for (int i = 0; i < GATE_DIVISION_COUNT; i++)
+			{
+				std::string text = GATE_DIVISIONS[i] == 1 ? "Every sample" : string::f("Every %d samples", GATE_DIVISIONS[i]);
+				menu->addChild(construct<GateDivisionItem>(&MenuItem::text, text, &TMRItem::module, module, &GateDivisionItem::division, GATE_DIVISIONS[i]));
+			}
+			return menu;
+		}
+	};
+
+	struct ReferenceNoteMenuItem : TMRItem
+	{
+		struct ReferenceNoteItem : TMRItem
+		{
+			int note;
+			void onAction(const event::Action &e) override { module->referenceNote = note; }
+			void step() override
+			{
+				rightText = (module->referenceNote == note) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Menu *createChildMenu() override
+		{
+			Menu *menu = new Menu;
+			for (int i = 0; i < REFERENCE_NOTE_COUNT; i++)
+			{
+				std::string text = string::f("%s (%d)", REFERENCE_NOTE_NAMES[i], REFERENCE_NOTES[i]);
+				menu->addChild(construct<ReferenceNoteItem>(&MenuItem::text, text, &TMRItem::module, module, &ReferenceNoteItem::note, REFERENCE_NOTES[i]));
+			}
+			return menu;
+		}
+	};
+
+	struct PitchChangeMenuItem : TMRItem
+	{
+		struct PitchChangeItem : TMRItem
+		{
+			int change;
+			void onAction(const event::Action &e) override { module->pitchChange = change; }
+			void step() override
+			{
+				rightText = (module->pitchChange == change) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Menu *createChildMenu() override
+		{
+			Menu *menu = new Menu;
+			for (int i = 0; i < PITCH_CHANGE_COUNT; i++)
+				menu->addChild(construct<PitchChangeItem>(&MenuItem::text, PITCH_CHANGE_NAMES[i], &TMRItem::module, module, &PitchChangeItem::change, i));
+			return menu;
+		}
+	};
+
+	struct AutomationControllerMenuItem : TMRItem
+	{
+		struct AutomationControllerItem : TMRItem
+		{
+			int controller;
+			void onAction(const event::Action &e) override { module->automationController = controller; }
+			void step() override
+			{
+				rightText = (module->automationController == controller) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Menu *createChildMenu() override
+		{
+			Menu *menu = new Menu;
+			for (int i = 0; i < AUTOMATION_CONTROLLER_COUNT; i++)
+			{
+				std::string text = string::f("%s (CC %d)", AUTOMATION_CONTROLLER_NAMES[i], AUTOMATION_CONTROLLERS[i]);
+				menu->addChild(construct<AutomationControllerItem>(&MenuItem::text, text, &TMRItem::module, module, &AutomationControllerItem::controller, AUTOMATION_CONTROLLERS[i]));
+			}
+			return menu;
+		}
+	};
+
+	struct AutomationToleranceMenuItem : TMRItem
+	{
+		struct AutomationToleranceItem : TMRItem
+		{
+			float tolerance;
+			void onAction(const event::Action &e) override { module->setAutomationTolerance(tolerance); }
+			void step() override
+			{
+				rightText = (module->automationTolerance == tolerance) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Menu *createChildMenu() override
+		{
+			Menu *menu = new Menu;
+			for (int i = 0; i < AUTOMATION_TOLERANCE_COUNT; i++)
+			{
+				const float tolerance = AUTOMATION_TOLERANCES[i];
+				std::string text = tolerance == 0.f ? "Off" : string::f("Within %g CC step%s", tolerance, tolerance == 1.f ? "" : "s");
+				menu->addChild(construct<AutomationToleranceItem>(&MenuItem::text, text, &TMRItem::module, module, &AutomationToleranceItem::tolerance, tolerance));
+			}
+			return menu;
+		}
+	};
+
+	struct EventsPerMinuteMenuItem : TMRItem
+	{
+		struct EventsPerMinuteItem : TMRItem
+		{
+			int events;
+			void onAction(const event::Action &e) override { module->setExpectedEventsPerMinute(events); }
+			void step() override
+			{
+				rightText = (module->expectedEventsPerMinute == events) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Menu *createChildMenu() override
+		{
+			Menu *menu = new Menu;
+			for (int i = 0; i < EVENTS_PER_MINUTE_COUNT; i++)
+			{
+				std::string text = string::f("%d (%d kB per minute)", EVENTS_PER_MINUTE[i], int(EVENTS_PER_MINUTE[i] * sizeof(TakeEvent) / 1000));
+				menu->addChild(construct<EventsPerMinuteItem>(&MenuItem::text, text, &TMRItem::module, module, &EventsPerMinuteItem::events, EVENTS_PER_MINUTE[i]));
+			}
+			return menu;
+		}
+	};
+
 	struct PathItem : TMRItem
 	{
 		void onAction(const event::Action &e) override { selectPath(module); }
@@ -402,7 +1758,7 @@ struct TenseMidiRecorderWidget : ModuleWidget
 
 	struct ShouldIncrementPathItem : TMRItem
 	{
-		void onAction(const event::Action &e) override { module->shouldIncrementPath ^= true; }
+		void onAction(const event::Action &e) override { module->setShouldIncrementPath(!module->shouldIncrementPath); }
 		void step() override
 		{
 			rightText = module->shouldIncrementPath ? CHECKMARK_STRING : "";
@@ -410,6 +1766,26 @@ struct TenseMidiRecorderWidget : ModuleWidget
 		}
 	};
 
+	struct StreamToDiskItem : TMRItem
+	{
+		void onAction(const event::Action &e) override { module->setStreamToDisk(!module->streamToDisk); }
+		void step() override
+		{
+			rightText = module->streamToDisk ? CHECKMARK_STRING : "";
+			MenuItem::step();
+		}
+	};
+
+	struct RetrospectiveItem : TMRItem
+	{
+		void onAction(const event::Action &e) override { module->setRetrospective(!module->retrospective); }
+		void step() override
+		{
+			rightText = module->retrospective ? CHECKMARK_STRING : "";
+			MenuItem::step();
+		}
+	};
+
 	struct PolyphonyAsDistinctTracks : TMRItem
 	{
 		void onAction(const event::Action &e) override { module->polyphonyAsDistinctTracks ^= true; }
@@ -1,8 +1,50 @@
 #include "plugin.hpp"
 
 #include "penners.hpp"
+#include "tensionbus.hpp"
+#include <emmintrin.h>
 
 #define TENSION_DISPLAY_SIZE 32
+#define TENSION_HISTORY_SIZE 32
+
+using simd::float_4;
+
+static constexpr int MAX_CHANNEL_SIZE = 16;
+static constexpr int MAX_GROUP_SIZE = MAX_CHANNEL_SIZE / 4;
+static constexpr int MAX_BLOCK_SIZE = 32;
+
+// Fixed point phase, 0 ... PHASE_ONE spans one run of the curve
+static constexpr int32_t PHASE_ONE = 1 << 30;
+static constexpr float PHASE_SCALE = 1.f / PHASE_ONE;
+
+// Rack's int32_4 has no min or max, and SSE4.1's aren't in Rack's SSE3 baseline, so compare and blend
+static inline rack::simd::int32_4 phaseMin(rack::simd::int32_4 a, rack::simd::int32_4 b)
+{
+	const __m128i greater = _mm_cmpgt_epi32(a.v, b.v);
+	return _mm_or_si128(_mm_and_si128(greater, b.v), _mm_andnot_si128(greater, a.v));
+}
+
+static inline rack::simd::int32_4 phaseMax(rack::simd::int32_4 a, rack::simd::int32_4 b)
+{
+	const __m128i greater = _mm_cmpgt_epi32(a.v, b.v);
+	return _mm_or_si128(_mm_and_si128(greater, a.v), _mm_andnot_si128(greater, b.v));
+}
+
+// Frames rendered per control step. Clock and trigger inputs are read once per block, so pulses
+// shorter than a block can be missed
+static const int BLOCK_SIZES[] = {1, 8, 16, 32};
+static const char *BLOCK_SIZE_NAMES[] = {"Off", "8", "16", "32"};
+static constexpr int BLOCK_SIZE_COUNT = sizeof(BLOCK_SIZES) / sizeof(BLOCK_SIZES[0]);
+
+// What the display needs from the engine, published at the light rate
+struct TensionSnapshot
+{
+	int easeType;
+	int easeMode;
+	int division;
+	float phase;								// First channel
+	float phaseHistory[TENSION_HISTORY_SIZE]; // Oldest first, one entry per publish
+};
 
 struct Tension : Module
 {
@@ -18,6 +60,9 @@ struct Tension : Module
 	{
 		CLOCKINPUT_INPUT,
 		TRIGGER_INPUT,
+		SHAPE_INPUT,
+		MODE_INPUT,
+		RATIO_INPUT,
 		NUM_INPUTS
 	};
 	enum OutputIds
@@ -36,6 +81,8 @@ struct Tension : Module
 	int clockMode = ClockMode::CLOCK;
 	int easeType = Ease::LINEAR;
 	int easeMode = Ease::BOTH;
+	int precision = Ease::EXACT;
+	int blockSize = 1;
 	int voltagePairs = VoltagePairs::NEGATIVE_10_TO_10;
 
 	bool shouldResetHard = false;
@@ -43,32 +90,64 @@ struct Tension : Module
 	//* DONT SAVE with RESET *//
 
 	RefreshCounter refreshCounter;
-	dsp::SchmittTrigger clockTrigger, inputTrigger;
 
-	double timeElapsed = 0.0; // Time that has elapsed
-	double duration = 0;	  // The total duration of the osc/animationFunc takes to complete
-	double phase = 0.0;		  // The time elapsed relative to the period of one function...
-	double amplitude = 0.0;   
+	// Voice state, structure of arrays with four voices per float_4...
+	dsp::TSchmittTrigger<float_4> inputTrigger[MAX_GROUP_SIZE];
+	ClockTracker<float_4> clockTracker[MAX_GROUP_SIZE];
+
+	float_4 duration[MAX_GROUP_SIZE];	 // The total duration of the osc/animationFunc takes to complete
+	rack::simd::int32_4 phase[MAX_GROUP_SIZE];	   // The time elapsed relative to the period of one function...
+	rack::simd::int32_4 increment[MAX_GROUP_SIZE]; // Phase step per frame, set at control rate
+	float_4 freq[MAX_GROUP_SIZE];
+	float_4 incrementDuration[MAX_GROUP_SIZE]; // duration and divisionRatio that freq and increment were last set from
+	float_4 incrementRatio[MAX_GROUP_SIZE];
+	float incrementManualFreq = -1.f; // Likewise for the whole module
+	float incrementSampleTime = -1.f;
+	bool incrementClocked = false;
+	float_4 b_buttonState[MAX_GROUP_SIZE];		 // Masks
+	float_4 bufferedTrigger[MAX_GROUP_SIZE];	 // Masks
+	float_4 gate[MAX_GROUP_SIZE];			 // Masks, latched from b_buttonState on trigger edges
+	float_4 previousTrigger[MAX_GROUP_SIZE];	 // Trigger voltage at the last control step
+	float_4 restarted[MAX_GROUP_SIZE];		 // Masks, voices reset in this control step
+	float_4 stretching[MAX_GROUP_SIZE];		 // Masks, voices whose duration is stretching with a late clock
+
+	double amplitude = 0.0;
 	double offset = 0.0;
-	double freq = 0.0;
 
+	int channels = 1;
 	int division = 0;
 
+	// CV modulation, added to the knob or menu selection. 0 V ... 10 V spans each one's full range
+	float_4 divisionRatio[MAX_GROUP_SIZE];
+	rack::simd::int32_4 morphFrom[MAX_GROUP_SIZE]; // Indices into the flattened Ease::Tables::table
+	rack::simd::int32_4 morphTo[MAX_GROUP_SIZE];
+	float_4 morphAmount[MAX_GROUP_SIZE];
+	bool isMorphing = false;
+
 	bool isClockConnected = false;
-	bool firstClockReceived = false;
-	bool secondClockReceived = false;
-	bool b_buttonState = true;
+
+	// Curve kernel, only re-selected when the shape, mode or precision changes
+	using Kernel = void (Tension::*)(int frames);
+	Kernel kernel = NULL;
+	const Ease::Table *table = NULL;
+	int kernelType = -1;
+	int kernelMode = -1;
+	int kernelPrecision = -1;
+	bool kernelMorphing = false;
+
+	// Rendered output of the current block, frame by group
+	float_4 block[MAX_BLOCK_SIZE][MAX_GROUP_SIZE];
+	int blockFrame = 0;
+	int currentBlockSize = 1; // blockSize as latched at the block's start, the menu can change it midway
 
 	float bufferedShapeKnob = 0.f;
 	float bufferedRatioKnob = 0.f;
-	float bufferedTriggerButton = 0.f;
 	float bufferedResetButton = 0.f;
 
-	double evaluate(double x)
-	{
-		//return Ease::EnumToFunction(Ease::Type(easeType))(Ease::Mode(easeMode), x, duration, amplitude, offset);
-		return Ease::EnumToFunction(Ease::Type(easeType))(Ease::Mode(easeMode), x);
-	}
+	// Display state, the UI thread only ever reads the snapshot
+	TripleBuffer<TensionSnapshot> snapshot;
+	float phaseHistory[TENSION_HISTORY_SIZE] = {};
+	int phaseHistoryIndex = 0;
 
 	Tension()
 	{
@@ -91,31 +170,217 @@ struct Tension : Module
 		//	configOutput(GATEOUTPUT_OUTPUT, "GATE");
 		//	configOutput(OUTPUT_OUTPUT, "CV OUT");
 
-		onReset();
-	}
+		for (int g = 0; g < MAX_GROUP_SIZE; g++)
+		{
+			duration[g] = 0.f;
+			phase[g] = 0;
+			increment[g] = 0;
+			freq[g] = 0.f;
+			incrementDuration[g] = NAN; // Never equal, so the first control step sets the increment
+			incrementRatio[g] = NAN;
+			divisionRatio[g] = 1.f;
+			morphFrom[g] = 0;
+			morphTo[g] = 0;
+			morphAmount[g] = 0.f;
+			b_buttonState[g] = float_4::mask();
+			bufferedTrigger[g] = float_4::zero();
+			gate[g] = float_4::zero();
+			previousTrigger[g] = 0.f;
+			restarted[g] = float_4::zero();
+			stretching[g] = float_4::zero();
+			inputTrigger[g].state = float_4::zero();
+		}
 
-	// Direction Must Always be FORWARD!!!!
-	void step(double dt)
-	{
-		double delta = fmin(freq * dt, 0.5);
-		phase += delta;
-		phase = clamp(phase);
+		// Bake the easing tables here rather than on the audio thread
+		Ease::GetTables();
+		updateKernel();
+
+		onReset();
+		publishSnapshot();
 	}
 
 	void onReset() override {}
 
-	void reset(bool hard)
+	// Resets the voices of group g selected by mask.
+	// lead is how far the phase runs from the reset to the next frame, beyond the one step the kernel adds
+	void reset(int g, float_4 mask, bool hard, rack::simd::int32_4 lead = 0)
 	{
-		// Reset The Phase...
-		phase = 1.0 - phase;
+		// Reset The Phase... mirrored where it stood at the reset, then caught up to the next frame
+		const rack::simd::int32_4 crossed = phaseMax(phaseMin(phase[g] - lead, PHASE_ONE), 0);
+		const rack::simd::int32_4 reset = PHASE_ONE - crossed + lead;
+		phase[g] = phase[g] ^ ((phase[g] ^ reset) & rack::simd::int32_4::cast(mask));
+		restarted[g] = restarted[g] | mask;
 
 		if (hard)
 		{
 			params[TRIGGER_PARAM].setValue(0.0);
-			b_buttonState = false;
+			b_buttonState[g] = simd::ifelse(mask, float_4::zero(), b_buttonState[g]);
 		}
 	}
 
+	void processClock(int g, float dt)
+	{
+		stretching[g] = float_4::zero();
+		if (!isClockConnected)
+		{
+			// TODO	Calculate BPM
+			duration[g] = 0.f;
+			clockTracker[g].reset();
+			return;
+		}
+
+		const float_4 clock = inputs[CLOCKINPUT_INPUT].getPolyVoltageSimd<float_4>(g * 4);
+		if (clockMode == ClockMode::BPM)
+		{
+			// 0 V = 120 BPM, 1 V/oct
+			const float_4 bpm = simd::pow(2.f, simd::clamp(clock, -10.f, 10.f)) * 120.f;
+			duration[g] = 60.f / bpm;
+			return;
+		}
+
+		// CLOCKMODE::CLOCK
+		ClockTracker<float_4> &tracker = clockTracker[g];
+		tracker.process(clock, dt);
+
+		// Stretch the period while waiting on a late clock, and fall back to the knob once it stops
+		const float_4 period = simd::ifelse(tracker.isLate(), tracker.elapsed, tracker.period);
+		duration[g] = simd::ifelse(tracker.locked, period, 0.f);
+		stretching[g] = tracker.isLate();
+	}
+
+	// Steps every voice and renders frames of output into block, with the curve inlined
+	template <Ease::Type type, Ease::Mode mode, Ease::Precision precision>
+	void processVoices(int frames)
+	{
+		for (int g = 0; g < (channels + 3) / 4; g++)
+		{
+			// Direction Must Always be FORWARD!!!! Stops at the end of the curve
+			const rack::simd::int32_4 delta = increment[g];
+			const float_4 buttonState = b_buttonState[g];
+			rack::simd::int32_4 _phase = phase[g];
+
+			for (int i = 0; i < frames; i++)
+			{
+				_phase = phaseMin(_phase + delta, PHASE_ONE);
+				const float_4 x = float_4(_phase) * PHASE_SCALE;
+
+				const float_4 value = precision == Ease::TABLE	   ? Ease::Lookup(*table, x)
+									  : precision == Ease::ECONOMY ? Ease::EvaluateEconomy<type, mode>(x)
+																   : Ease::Evaluate<type, mode>(x);
+				const float_4 tension = simd::ifelse(buttonState, 1.f - value, value);
+				block[i][g] = tension * 10.f; // Sets Voltage 0 V ... 10 V
+			}
+
+			phase[g] = _phase;
+		}
+	}
+
+	// Exact and Economy kernels per curve, the table kernel doesn't depend on the curve
+	static Kernel getKernel(Ease::Type type, Ease::Mode mode, Ease::Precision precision)
+	{
+		precision = Ease::Effective(type, mode, precision);
+#define TENSION_KERNELS(type, precision) {&Tension::processVoices<type, Ease::IN, precision>, &Tension::processVoices<type, Ease::OUT, precision>, &Tension::processVoices<type, Ease::BOTH, precision>}
+#define TENSION_PRECISION_KERNELS(precision)       \
+	{                                              \
+		TENSION_KERNELS(Ease::LINEAR, precision),  \
+		TENSION_KERNELS(Ease::SINE, precision),    \
+		TENSION_KERNELS(Ease::EXPO, precision),    \
+		TENSION_KERNELS(Ease::CIRC, precision),    \
+		TENSION_KERNELS(Ease::CUBIC, precision),   \
+		TENSION_KERNELS(Ease::QUAD, precision),    \
+		TENSION_KERNELS(Ease::QUART, precision),   \
+		TENSION_KERNELS(Ease::QUINT, precision),   \
+		TENSION_KERNELS(Ease::BACK, precision),    \
+		TENSION_KERNELS(Ease::ELASTIC, precision), \
+		TENSION_KERNELS(Ease::BOUNCE, precision),  \
+	}
+		static const Kernel kernels[2][Ease::COUNT][3] = {
+			TENSION_PRECISION_KERNELS(Ease::EXACT),
+			TENSION_PRECISION_KERNELS(Ease::ECONOMY),
+		};
+#undef TENSION_PRECISION_KERNELS
+#undef TENSION_KERNELS
+		if (precision == Ease::TABLE)
+			return &Tension::processVoices<Ease::LINEAR, Ease::IN, Ease::TABLE>;
+		return kernels[precision == Ease::ECONOMY][type][mode];
+	}
+
+	// Shape or mode under CV. Each voice crossfades between two adjacent curves from the tables,
+	// so the CV can move at audio rate while the kernel stays put
+	void processVoicesMorph(int frames)
+	{
+		const Ease::Table *tables = &Ease::GetTables().table[0][0];
+		for (int g = 0; g < (channels + 3) / 4; g++)
+		{
+			const rack::simd::int32_4 delta = increment[g];
+			const float_4 buttonState = b_buttonState[g];
+			const rack::simd::int32_4 from = morphFrom[g];
+			const rack::simd::int32_4 to = morphTo[g];
+			const float_4 amount = morphAmount[g];
+			rack::simd::int32_4 _phase = phase[g];
+
+			for (int i = 0; i < frames; i++)
+			{
+				_phase = phaseMin(_phase + delta, PHASE_ONE);
+
+				const float_4 value = Ease::Lookup(tables, from, to, amount, float_4(_phase) * PHASE_SCALE);
+				const float_4 tension = simd::ifelse(buttonState, 1.f - value, value);
+				block[i][g] = tension * 10.f;
+			}
+
+			phase[g] = _phase;
+		}
+	}
+
+	void updateKernel()
+	{
+		if (kernelType == easeType && kernelMode == easeMode && kernelPrecision == precision && kernelMorphing == isMorphing)
+			return;
+
+		kernelType = easeType;
+		kernelMode = easeMode;
+		kernelPrecision = precision;
+		kernelMorphing = isMorphing;
+
+		table = &Ease::GetTable(Ease::Type(easeType), Ease::Mode(easeMode));
+		if (isMorphing)
+			kernel = &Tension::processVoicesMorph;
+		else
+			kernel = getKernel(Ease::Type(easeType), Ease::Mode(easeMode), Ease::Precision(precision));
+	}
+
+	// Control rate, so CV changes land on the next block rather than the next input poll
+	void processModulation(int g)
+	{
+		const int c = g * 4;
+
+		if (inputs[RATIO_INPUT].isConnected())
+		{
+			const float_4 cv = inputs[RATIO_INPUT].getPolyVoltageSimd<float_4>(c);
+			const float_4 position = simd::clamp(division + cv * float(DIVISION_COUNT - 1) / 10.f + 0.5f, 0.f, float(DIVISION_COUNT - 1));
+			const rack::simd::int32_4 index = rack::simd::int32_4(position);
+			divisionRatio[g] = float_4(DIVISIONS[index[0]], DIVISIONS[index[1]], DIVISIONS[index[2]], DIVISIONS[index[3]]);
+		}
+		else
+		{
+			divisionRatio[g] = DIVISIONS[division];
+		}
+
+		if (!isMorphing)
+			return;
+
+		const float_4 shapeCv = inputs[SHAPE_INPUT].getNormalPolyVoltageSimd<float_4>(0.f, c);
+		const float_4 shape = simd::clamp(easeType + shapeCv * float(Ease::COUNT - 1) / 10.f, 0.f, float(Ease::COUNT - 1));
+		const float_4 modeCv = inputs[MODE_INPUT].getNormalPolyVoltageSimd<float_4>(0.f, c);
+		const float_4 mode = float_4(rack::simd::int32_4(simd::clamp(easeMode + modeCv * 2.f / 10.f + 0.5f, 0.f, 2.f)));
+
+		// The last curve morphs in from the one before it, so there's always a next table
+		const float_4 lower = simd::fmin(float_4(rack::simd::int32_4(shape)), float(Ease::COUNT - 2));
+		morphAmount[g] = shape - lower;
+		morphFrom[g] = rack::simd::int32_4(lower * 3.f + mode);
+		morphTo[g] = rack::simd::int32_4((lower + 1.f) * 3.f + mode);
+	}
+
 	json_t *dataToJson() override
 	{
 		json_t *json = json_object();
@@ -123,6 +388,8 @@ struct Tension : Module
 		json_object_set_new(json, "clockMode", json_integer(clockMode));
 		json_object_set_new(json, "easeMode", json_integer(easeMode));
 		json_object_set_new(json, "easeType", json_integer(easeType));
+		json_object_set_new(json, "precision", json_integer(precision));
+		json_object_set_new(json, "blockSize", json_integer(blockSize));
 
 		return json;
 	}
@@ -132,54 +399,82 @@ struct Tension : Module
 		auto* jsonDef = json_object_get(json, "clockMode");
 		if(jsonDef) clockMode = json_integer_value(jsonDef);
 		jsonDef = json_object_get(json, "easeMode");
-		if(jsonDef) easeMode = json_integer_value(jsonDef);
+		if(jsonDef) easeMode = clamp((int)json_integer_value(jsonDef), (int)Ease::IN, (int)Ease::BOTH);
 		jsonDef = json_object_get(json, "easeType");
-		if(jsonDef) easeType = json_integer_value(jsonDef);
+		if(jsonDef) easeType = clamp((int)json_integer_value(jsonDef), 0, Ease::COUNT - 1);
+		jsonDef = json_object_get(json, "precision");
+		if(jsonDef) precision = clamp((int)json_integer_value(jsonDef), (int)Ease::EXACT, (int)Ease::ECONOMY);
+		jsonDef = json_object_get(json, "blockSize");
+		if(jsonDef) blockSize = clamp((int)json_integer_value(jsonDef), 1, MAX_BLOCK_SIZE);
 	}
 
-	void process(const ProcessArgs &args) override
+	// Control rate state, run once per block
+	void processControl(float dt, bool pollInputs)
 	{
-		timeElapsed += 1.0 / args.sampleRate;
+		channels = std::max(1, std::max(inputs[CLOCKINPUT_INPUT].getChannels(), inputs[TRIGGER_INPUT].getChannels()));
+		isClockConnected = inputs[CLOCKINPUT_INPUT].isConnected();
+		isMorphing = inputs[SHAPE_INPUT].isConnected() || inputs[MODE_INPUT].isConnected();
+
+		// Set BPM Manually if Clock is not connected...
+		const float manualFreq = 1.0 / clamp(60.0f / bufferedRatioKnob, DURATION_MIN_F, DURATION_MAX_F);
+
+		// On Button Press, set isRunningToTrue...
+		// Input Takes Priority...
+		const float button = params[TRIGGER_PARAM].getValue();
+		const float sampleTime = dt / currentBlockSize;
+
+		// The increment only follows the duration, ratio, knob and sample time, so it is kept until one changes.
+		// Lock and late flips change the duration, and a late clock stretches it every step
+		const bool rateChanged = manualFreq != incrementManualFreq || sampleTime != incrementSampleTime || isClockConnected != incrementClocked;
+		incrementManualFreq = manualFreq;
+		incrementSampleTime = sampleTime;
+		incrementClocked = isClockConnected;
 
 		// Clock Pin
-		if (inputs[CLOCKINPUT_INPUT].isConnected())
+		for (int c = 0; c < channels; c += 4)
 		{
-			if (ClockMode::BPM)
+			const int g = c / 4;
+			restarted[g] = float_4::zero();
+			processClock(g, dt);
+			processModulation(g);
+
+			if (rateChanged || simd::movemask((duration[g] != incrementDuration[g]) | (divisionRatio[g] != incrementRatio[g])))
 			{
-				double bpm = powf(1.0, clamp(inputs[CLOCKINPUT_INPUT].getVoltage(), -10.0f, 10.0f)) * 120.0;
-				duration = 60.0 / bpm;
+				incrementDuration[g] = duration[g];
+				incrementRatio[g] = divisionRatio[g];
+
+				if (isClockConnected)
+					freq[g] = simd::ifelse(duration[g] != 0.f, divisionRatio[g] / duration[g], manualFreq);
+				else
+					freq[g] = manualFreq;
+
+				// Capped at half a run per frame, so a reset always shows
+				increment[g] = rack::simd::int32_4(simd::fmin(freq[g] * sampleTime, 0.5f) * float(PHASE_ONE));
 			}
-			else
+
+			// Triggers every control step, so short pulses aren't missed and retriggers keep their timing
+			const float_4 trigger = inputs[TRIGGER_INPUT].getPolyVoltageSimd<float_4>(c) + button;
+			inputTrigger[g].process(trigger);
+			const float_4 changed = inputTrigger[g].state ^ bufferedTrigger[g];
+			if (simd::movemask(changed))
 			{
-				// CLOCKMODE::CLOCK
-				if (clockTrigger.process(inputs[CLOCKINPUT_INPUT].getVoltage()))
-				{
-					if (firstClockReceived)
-					{
-						duration = timeElapsed;
-						secondClockReceived = true;
-					}
-					timeElapsed = 0;
-					firstClockReceived = true;
-				}
-				else if (secondClockReceived && timeElapsed > duration)
-				{
-					duration = timeElapsed;
-				}
+				// Crossed 1 V going high or 0 V going low this far back into the step
+				const float_4 threshold = inputTrigger[g].state & 1.f;
+				const float_4 before = simd::clamp((trigger - threshold) / (trigger - previousTrigger[g]), 0.f, 1.f) * dt;
+
+				bufferedTrigger[g] = inputTrigger[g].state;
+				b_buttonState[g] = simd::ifelse(changed, inputTrigger[g].state, b_buttonState[g]);
+				// Capped like the increment, a fast curve would otherwise overflow the phase
+				const float_4 lead = simd::fmin(freq[g] * before, 0.5f) * float(PHASE_ONE);
+				reset(g, changed, shouldResetHard, rack::simd::int32_4(lead) - increment[g]);
+				// After the reset, so a hard reset holds the gate low
+				gate[g] = simd::ifelse(changed, b_buttonState[g], gate[g]);
 			}
-			isClockConnected = true;
-		}
-		else
-		{
-			// TODO	Calculate BPM
-			duration = 0.0f;
-			firstClockReceived = false;
-			secondClockReceived = false;
-			isClockConnected = false;
+			previousTrigger[g] = trigger;
 		}
 
 		// GUI Refresh
-		if (refreshCounter.processInputs())
+		if (pollInputs)
 		{
 			const auto shape_value = params[SHAPESLIDER_PARAM].getValue();
 			if (bufferedShapeKnob != shape_value)
@@ -188,54 +483,105 @@ struct Tension : Module
 				easeType = int(clamp(bufferedShapeKnob, 0.0f, (float)Ease::Type::COUNT - 1));
 			}
 
+			// Also picks up changes from the context menu
+			updateKernel();
+
 			const auto ratio_value = params[RATIOSLIDER_PARAM].getValue();
 			if (bufferedRatioKnob != ratio_value)
 			{
 				bufferedRatioKnob = ratio_value;
 				division = int(clamp(bufferedRatioKnob, 0.0f, 26.0f));
-
-				if (isClockConnected && duration != 0)
-				{
-					freq = 1.0 / (duration / DIVISIONS[division]);
-				}
-				else
-				{
-					// Set BPM Manually if Clock is not connected...
-					duration = clamp(60.0f / bufferedRatioKnob, DURATION_MIN_F, DURATION_MAX_F);
-					freq = 1.0 / duration;
-				}
-			}
-
-			// On Button Press, set isRunningToTrue...
-			// Input Takes Priority...
-			const auto _input = inputs[TRIGGER_INPUT].getVoltage() + params[TRIGGER_PARAM].getValue();
-			if (bufferedTriggerButton != _input)
-			{
-				bufferedTriggerButton = _input;
-				b_buttonState = _input != 0.0;
-				reset(shouldResetHard);
-				outputs[GATEOUTPUT_OUTPUT].setVoltage(b_buttonState * 10.0);
 			}
 
 			const auto reset_value = params[RESET_PARAM].getValue();
 			if (bufferedResetButton != reset_value)
 			{
 				bufferedResetButton = reset_value;
-				reset(reset_value == 1.0);
+				for (int c = 0; c < channels; c += 4)
+					reset(c / 4, float_4::mask(), reset_value == 1.0);
 			}
 		}
+	}
+
+	void process(const ProcessArgs &args) override
+	{
+		// In block mode the control state is latched once per block, clock and triggers included
+		if (blockFrame >= currentBlockSize)
+			blockFrame = 0;
 
-		step(1.0 / args.sampleRate);
+		// A recorder on the right picks up the curves without a cable
+		Module *recorder = rightExpander.module && rightExpander.module->model == modelTenseMidiRecorder ? rightExpander.module : NULL;
+
+		if (blockFrame == 0)
+		{
+			currentBlockSize = blockSize;
+			const float dt = args.sampleTime;
+			processControl(dt * currentBlockSize, currentBlockSize > 1 || refreshCounter.processInputs());
+			if (recorder)
+				sendVoices(recorder);
+			(this->*kernel)(currentBlockSize);
+		}
+		else if (recorder)
+		{
+			// Sent every frame all the same, so a flip never hands the recorder a control step twice
+			static_cast<TensionBusMessage *>(recorder->leftExpander.producerMessage)->channels = 0;
+			recorder->leftExpander.messageFlipRequested = true;
+		}
+
+		for (int c = 0; c < channels; c += 4)
+		{
+			const int g = c / 4;
+			outputs[GATEOUTPUT_OUTPUT].setVoltageSimd(gate[g] & 10.f, c);
+			outputs[OUTPUT_OUTPUT].setVoltageSimd(block[blockFrame][g], c);
+		}
+
+		outputs[GATEOUTPUT_OUTPUT].setChannels(channels);
+		outputs[OUTPUT_OUTPUT].setChannels(channels);
+
+		blockFrame++;
 
 		// Light Processing... // Call this to increment Refresh Count
 		if (refreshCounter.processLights())
 		{
+			publishSnapshot();
 		}
+	}
 
-		double tension = b_buttonState ? 1 - evaluate(phase) : evaluate(phase);
+	// Each voice as the control step left it, the run it's on starting from phase
+	void sendVoices(Module *recorder)
+	{
+		TensionBusMessage *message = static_cast<TensionBusMessage *>(recorder->leftExpander.producerMessage);
+		message->channels = std::min(channels, (int)TensionBusMessage::MAX_VOICES);
+		for (int c = 0; c < message->channels; c++)
+		{
+			const int g = c / 4;
+			const int i = c % 4;
+
+			TensionVoice &voice = message->voices[c];
+			voice.shape = isMorphing ? morphFrom[g][i] / 3 + morphAmount[g][i] : easeType;
+			voice.mode = isMorphing ? morphFrom[g][i] % 3 : easeMode;
+			voice.duration = freq[g][i] > 0.f ? 1.f / freq[g][i] : 0.f;
+			voice.phase = phase[g][i] * PHASE_SCALE;
+			voice.falling = simd::movemask(b_buttonState[g]) & (1 << i);
+			voice.restarted = simd::movemask(restarted[g]) & (1 << i);
+			voice.stretching = simd::movemask(stretching[g]) & (1 << i);
+		}
+		recorder->leftExpander.messageFlipRequested = true;
+	}
 
-		//outputs[GATEOUTPUT_OUTPUT].setVoltage(phase);
-		outputs[OUTPUT_OUTPUT].setVoltage(tension * 10.0); // Sets Voltage 0 V ... 10 V
+	void publishSnapshot()
+	{
+		phaseHistory[phaseHistoryIndex] = phase[0][0] * PHASE_SCALE;
+		phaseHistoryIndex = (phaseHistoryIndex + 1) % TENSION_HISTORY_SIZE;
+
+		TensionSnapshot &state = snapshot.back();
+		state.easeType = easeType;
+		state.easeMode = easeMode;
+		state.division = division;
+		state.phase = phase[0][0] * PHASE_SCALE;
+		for (int i = 0; i < TENSION_HISTORY_SIZE; i++)
+			state.phaseHistory[i] = phaseHistory[(phaseHistoryIndex + i) % TENSION_HISTORY_SIZE];
+		snapshot.publish();
 	}
 };
 
@@ -244,7 +590,7 @@ struct TensionWidget : ModuleWidget
 	TensionWidget(Tension *module)
 	{
 		setModule(module);
-		setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Tension.svg")));
+		setPanel(Resources::getSvg(Resources::TENSION_PANEL));
 
 		addParam(createParamCentered<TToggleButton>(mm2px(Vec(7.67, 12.0)), module, Tension::TRIGGER_PARAM));
 		addParam(createParamCentered<TMicroButton>(mm2px(Vec(11.094, 20.5)), module, Tension::RESET_PARAM));
@@ -254,11 +600,16 @@ struct TensionWidget : ModuleWidget
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.763, 71.419)), module, Tension::CLOCKINPUT_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(7.763, 86.659)), module, Tension::TRIGGER_INPUT));
 
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(20.32, 37.242)), module, Tension::SHAPE_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(20.32, 56.241)), module, Tension::RATIO_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(20.32, 75.240)), module, Tension::MODE_INPUT));
+
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(7.763, 101.659)), module, Tension::GATEOUTPUT_OUTPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(7.763, 116.899)), module, Tension::OUTPUT_OUTPUT));
 
 		BHTensionDisplay *display = new BHTensionDisplay();
 		display->module = module;
+		display->box.size = box.size;
 		display->shapeRect = Rect(mm2px(Vec(1.574, 24.703)), mm2px(Vec(12.192, 5.0)));
 		display->ratioRect = Rect(mm2px(Vec(1.574, 43.702)), mm2px(Vec(12.192, 5.0)));
 		addChild(display);
@@ -279,6 +630,8 @@ struct TensionWidget : ModuleWidget
 		// Easing
 		menu->addChild(construct<EaseTypeMenuItem>(&MenuItem::text, "Shape", &MenuItem::rightText, RIGHT_ARROW, &EaseTypeMenuItem::module, module));
 		menu->addChild(construct<EaseModeMenuItem>(&MenuItem::text, "Mode", &MenuItem::rightText, RIGHT_ARROW, &EaseModeMenuItem::module, module));
+		menu->addChild(construct<PrecisionMenuItem>(&MenuItem::text, "Precision", &MenuItem::rightText, RIGHT_ARROW, &PrecisionMenuItem::module, module));
+		menu->addChild(construct<BlockSizeMenuItem>(&MenuItem::text, "Block size", &MenuItem::rightText, RIGHT_ARROW, &BlockSizeMenuItem::module, module));
 
 		menu->addChild(new MenuSeparator());
 
@@ -381,18 +734,137 @@ struct TensionWidget : ModuleWidget
 		}
 	};
 
+	struct PrecisionMenuItem : MenuItem
+	{
+		struct PrecisionItem : MenuItem
+		{
+			Tension *module;
+			Ease::Precision precision;
+			void onAction(const event::Action &e) override { module->precision = precision; }
+			void step() override
+			{
+				const Ease::Precision effective = Ease::Effective(Ease::Type(module->easeType), Ease::Mode(module->easeMode), Ease::Precision(module->precision));
+				rightText = (effective == precision) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Tension *module;
+		Menu *createChildMenu() override
+		{
+			// Worst case deviation of the current curve, at the 10 V output
+			const Ease::Table &table = Ease::GetTable(Ease::Type(module->easeType), Ease::Mode(module->easeMode));
+			std::string economyText = string::f("%s (±%.2f mV)", EnumToString(Ease::ECONOMY), table.economyError * 10.f * 1000.f);
+			std::string tableText = string::f("%s (±%.2f mV)", EnumToString(Ease::TABLE), table.error * 10.f * 1000.f);
+
+			Menu *menu = new Menu;
+			menu->addChild(construct<PrecisionItem>(&MenuItem::text, EnumToString(Ease::EXACT), &PrecisionItem::module, module, &PrecisionItem::precision, Ease::EXACT));
+			if (Ease::IsApproximated(Ease::Type(module->easeType), Ease::Mode(module->easeMode)))
+			{
+				menu->addChild(construct<PrecisionItem>(&MenuItem::text, economyText, &PrecisionItem::module, module, &PrecisionItem::precision, Ease::ECONOMY));
+				menu->addChild(construct<PrecisionItem>(&MenuItem::text, tableText, &PrecisionItem::module, module, &PrecisionItem::precision, Ease::TABLE));
+			}
+			return menu;
+		}
+	};
+
+	struct BlockSizeMenuItem : MenuItem
+	{
+		struct BlockSizeItem : MenuItem
+		{
+			Tension *module;
+			int blockSize;
+			void onAction(const event::Action &e) override { module->blockSize = blockSize; }
+			void step() override
+			{
+				rightText = (module->blockSize == blockSize) ? CHECKMARK_STRING : "";
+				MenuItem::step();
+			}
+		};
+
+		Tension *module;
+		Menu *createChildMenu() override
+		{
+			Menu *menu = new Menu;
+			for (int i = 0; i < BLOCK_SIZE_COUNT; i++)
+				menu->addChild(construct<BlockSizeItem>(&MenuItem::text, BLOCK_SIZE_NAMES[i], &BlockSizeItem::module, module, &BlockSizeItem::blockSize, BLOCK_SIZES[i]));
+			return menu;
+		}
+	};
+
 	//* Custom Widgets *//
 
+	// The curve is only rasterized when the shape changes, the framebuffer is reused in between.
+	// Its box covers shapeRect alone, so the framebuffer is no bigger than the curve
+	struct BHTensionShape : TransparentWidget
+	{
+		Rect shapeRect; // In the display's coordinates, as are the points
+		float curve[TENSION_DISPLAY_SIZE + 1] = {};
+
+		void update(Ease::Type type, Ease::Mode mode)
+		{
+			for (int i = 0; i <= TENSION_DISPLAY_SIZE; i++)
+				curve[i] = i / (float)TENSION_DISPLAY_SIZE;
+			Ease::EvaluateBlock(type, mode, curve, curve, TENSION_DISPLAY_SIZE + 1);
+		}
+
+		Vec getPoint(int i)
+		{
+			return Vec(shapeRect.pos.x + i * shapeRect.size.x / TENSION_DISPLAY_SIZE,
+					   shapeRect.pos.y + (1.f - curve[i]) * shapeRect.size.y);
+		}
+
+		// Between the cached points, for phases that don't land on one
+		Vec getPoint(float x)
+		{
+			float index = clamp(x, 0.f, 1.f) * TENSION_DISPLAY_SIZE;
+			int i = std::min((int)index, TENSION_DISPLAY_SIZE - 1);
+			float y = crossfade(curve[i], curve[i + 1], index - i);
+			return Vec(shapeRect.pos.x + index * shapeRect.size.x / TENSION_DISPLAY_SIZE,
+					   shapeRect.pos.y + (1.f - y) * shapeRect.size.y);
+		}
+
+		void draw(const DrawArgs &args) override
+		{
+			nvgSave(args.vg);
+			nvgTranslate(args.vg, -shapeRect.pos.x, -shapeRect.pos.y);
+			nvgScissor(args.vg, shapeRect.pos.x, shapeRect.pos.y, shapeRect.size.x, shapeRect.size.y);
+			nvgStrokeColor(args.vg, nvgTransRGBAf(Colors::LIGHT, 0.35f));
+			nvgStrokeWidth(args.vg, 1.0);
+
+			nvgBeginPath(args.vg);
+			Vec point = getPoint(0);
+			nvgMoveTo(args.vg, point.x, point.y);
+			for (int i = 1; i <= TENSION_DISPLAY_SIZE; i++)
+			{
+				point = getPoint(i);
+				nvgLineTo(args.vg, point.x, point.y);
+			}
+			nvgStroke(args.vg);
+			nvgRestore(args.vg);
+		}
+	};
+
 	struct BHTensionDisplay : TransparentWidget
 	{
 		Tension *module;
 		std::shared_ptr<Font> font;
-		std::string fontPath;
 		Rect shapeRect, ratioRect;
 
+		FramebufferWidget *framebuffer;
+		BHTensionShape *shape;
+		const TensionSnapshot *state = NULL; // Read once per frame, from the engine's snapshot
+		int easeType = -1;
+		int easeMode = -1;
+
 		BHTensionDisplay()
 		{
-			fontPath = std::string(asset::plugin(pluginInstance, "res/fonts/MajorMonoDisplay-Regular.ttf"));
+			font = Resources::getFont(Resources::DISPLAY_FONT);
+
+			framebuffer = new FramebufferWidget;
+			addChild(framebuffer);
+			shape = new BHTensionShape;
+			framebuffer->addChild(shape);
 		}
 
 		void drawBpmRatioText(const DrawArgs &args)
@@ -403,7 +875,7 @@ struct TensionWidget : ModuleWidget
 
 			char text[32];
 			Vec textPos = Vec(ratioRect.pos.x - ratioRect.size.x / 8.0, ratioRect.pos.y + ratioRect.size.y - ratioRect.size.y / 4);
-			snprintf(text, sizeof(text), " %s", DIVISION_NAMES[module->division]);
+			snprintf(text, sizeof(text), " %s", DIVISION_NAMES[state->division]);
 			nvgText(args.vg, textPos.x, textPos.y, text, NULL);
 		}
 
@@ -415,59 +887,70 @@ struct TensionWidget : ModuleWidget
 
 			char text[32];
 			Vec textPos = Vec(shapeRect.pos.x - shapeRect.size.x / 8.0, shapeRect.pos.y + shapeRect.size.y - shapeRect.size.y / 4);
-			snprintf(text, sizeof(text), " %s", Ease::TypeIdStrings[module->easeType]);
+			snprintf(text, sizeof(text), " %s", Ease::TypeIdStrings[state->easeType]);
 			nvgText(args.vg, textPos.x, textPos.y, text, NULL);
 		}
 
-		void drawShape(const DrawArgs &args)
+		// Overlay on the cached curve, the only part drawn every frame
+		void drawProgress(const DrawArgs &args)
 		{
-			nvgStrokeColor(args.vg, Colors::LIGHT);
 			nvgStrokeWidth(args.vg, 1.0);
+			NVGpaint paint = nvgLinearGradient(args.vg, 0, shapeRect.pos.y, 0, shapeRect.pos.y + shapeRect.size.y, Colors::ACCENT, nvgTransRGBAf(Colors::ACCENT, 0.2f));
+			nvgStrokePaint(args.vg, paint);
 
+			nvgSave(args.vg);
+			nvgScissor(args.vg, shapeRect.pos.x, shapeRect.pos.y, shapeRect.size.x, shapeRect.size.y);
 			nvgBeginPath(args.vg);
-			Vec startingPoint = Vec(shapeRect.pos.x, shapeRect.pos.y);
-			nvgMoveTo(args.vg, startingPoint.x, startingPoint.y + module->evaluate(0.0) * shapeRect.size.y);
-			for (int i = 1; i < TENSION_DISPLAY_SIZE; i++)
+
+			float progress = clamp(state->phase, 0.f, 1.f);
+			for (int i = 0; i <= progress * TENSION_DISPLAY_SIZE; i++)
 			{
-				nvgLineTo(args.vg,
-						  shapeRect.pos.x + (i / TENSION_DISPLAY_SIZE) * shapeRect.size.x,
-						  shapeRect.pos.y + module->evaluate(i / TENSION_DISPLAY_SIZE) * shapeRect.size.y);
+				Vec point = shape->getPoint(i);
+				nvgMoveTo(args.vg, point.x, point.y);
+				nvgLineTo(args.vg, point.x, shapeRect.pos.y + shapeRect.size.y);
 			}
-
 			nvgStroke(args.vg);
+
+			// Recent phases trail off behind the current one
+			for (int i = 0; i < TENSION_HISTORY_SIZE; i++)
+			{
+				Vec point = shape->getPoint(state->phaseHistory[i]);
+				nvgFillColor(args.vg, nvgTransRGBAf(Colors::ACCENT, (i + 1) / (float)TENSION_HISTORY_SIZE));
+				nvgBeginPath(args.vg);
+				nvgCircle(args.vg, point.x, point.y, 1.0);
+				nvgFill(args.vg);
+			}
+			nvgRestore(args.vg);
 		}
 
-		void drawProgress(const DrawArgs &args)
+		void step() override
 		{
-			nvgStrokeWidth(args.vg, 1.0);
-			NVGpaint paint = nvgLinearGradient(args.vg, 0, 0, 0, 151, Colors::ACCENT, nvgTransRGBAf(Colors::ACCENT, 0.2f));
-			nvgStrokePaint(args.vg, paint);
-
-			nvgBeginPath(args.vg);
+			if (!module)
+				return;
 
-			float progress = module->phase;
-			for (int i = 0; i < progress * TENSION_DISPLAY_SIZE; i++)
+			state = &module->snapshot.read();
+			if (easeType != state->easeType || easeMode != state->easeMode)
 			{
-				nvgMoveTo(args.vg, shapeRect.pos.x + (i / progress * TENSION_DISPLAY_SIZE) * shapeRect.size.x,
-						  shapeRect.pos.y + module->evaluate(i / progress * TENSION_DISPLAY_SIZE) * shapeRect.size.y);
-				nvgLineTo(args.vg, shapeRect.pos.x + (i / progress * TENSION_DISPLAY_SIZE) * shapeRect.size.x, shapeRect.pos.y + shapeRect.size.y);
+				easeType = state->easeType;
+				easeMode = state->easeMode;
+				framebuffer->box = shapeRect;
+				shape->box.size = shapeRect.size;
+				shape->shapeRect = shapeRect;
+				shape->update(Ease::Type(easeType), Ease::Mode(easeMode));
+				framebuffer->dirty = true;
 			}
-			nvgStroke(args.vg);
+			TransparentWidget::step();
 		}
 
 		void draw(const DrawArgs &args) override
 		{
-			font = APP->window->loadFont(fontPath);
-
-			if (!module)
+			if (!state)
 				return;
 
+			TransparentWidget::draw(args);
+			drawProgress(args);
 			drawBpmRatioText(args);
 			drawTypeText(args);
-
-			// TODO...
-			// drawShape(args);
-			// drawProgress(args);
 		}
 	};
 };
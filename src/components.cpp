@@ -5,3 +5,43 @@ const NVGcolor Colors::FG = NVGcolor(color::fromHexString("#f2f2f2"));
 const NVGcolor Colors::PRIMARY = NVGcolor(color::fromHexString("#031d44"));
 const NVGcolor Colors::ACCENT = NVGcolor(color::fromHexString("#e4572e"));
 const NVGcolor Colors::LIGHT = NVGcolor(color::fromHexString("#4bc7e9"));
+
+static const char *SVG_PATHS[Resources::SVG_COUNT] = {
+	"res/components/TToggleButton_0.svg",
+	"res/components/TToggleButton_1.svg",
+	"res/components/TMicroButton_0.svg",
+	"res/components/TMicroButton_1.svg",
+	"res/components/TTinyKnob.svg",
+	"res/Tension.svg",
+	"res/TenseMidiRecorder.svg",
+};
+static const char *FONT_PATHS[Resources::FONT_COUNT] = {
+	"res/fonts/MajorMonoDisplay-Regular.ttf",
+};
+
+static std::string svgPaths[Resources::SVG_COUNT];
+static std::string fontPaths[Resources::FONT_COUNT];
+static std::shared_ptr<Svg> svgs[Resources::SVG_COUNT];
+static std::shared_ptr<Font> fonts[Resources::FONT_COUNT];
+
+void Resources::init(Plugin *plugin)
+{
+	for (int i = 0; i < SVG_COUNT; i++)
+		svgPaths[i] = asset::plugin(plugin, SVG_PATHS[i]);
+	for (int i = 0; i < FONT_COUNT; i++)
+		fontPaths[i] = asset::plugin(plugin, FONT_PATHS[i]);
+}
+
+std::shared_ptr<Svg> Resources::getSvg(SvgIds id)
+{
+	if (!svgs[id])
+		svgs[id] = APP->window->loadSvg(svgPaths[id]);
+	return svgs[id];
+}
+
+std::shared_ptr<Font> Resources::getFont(FontIds id)
+{
+	if (!fonts[id])
+		fonts[id] = APP->window->loadFont(fontPaths[id]);
+	return fonts[id];
+}
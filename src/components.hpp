@@ -13,6 +13,7 @@
 #pragma once
 
 #include <rack.hpp>
+#include <atomic>
 
 using namespace rack;
 
@@ -46,6 +47,32 @@ struct Colors
     static const NVGcolor LIGHT;
 };
 
+/// Artwork shared by every instance. Paths are resolved once from init(), and each handle is loaded
+/// on first use, since Rack creates its window after plugins are initialized. UI thread only
+struct Resources
+{
+    enum SvgIds
+    {
+        TOGGLE_BUTTON_0,
+        TOGGLE_BUTTON_1,
+        MICRO_BUTTON_0,
+        MICRO_BUTTON_1,
+        TINY_KNOB,
+        TENSION_PANEL,
+        TENSE_MIDI_RECORDER_PANEL,
+        SVG_COUNT
+    };
+    enum FontIds
+    {
+        DISPLAY_FONT,
+        FONT_COUNT
+    };
+
+    static void init(Plugin *plugin);
+    static std::shared_ptr<Svg> getSvg(SvgIds id);
+    static std::shared_ptr<Font> getFont(FontIds id);
+};
+
 enum VoltagePairs
 {
     NEGATIVE_10_TO_10,
@@ -97,6 +124,207 @@ struct RefreshCounter
     }
 };
 
+/// Lock free ring buffer for one producer and one consumer thread, S must be a power of 2.
+/// Storage is inline, so neither side ever allocates.
+template <typename T, size_t S>
+struct SpscRingBuffer
+{
+    static_assert((S & (S - 1)) == 0, "S must be a power of 2");
+
+    /// Producer. Returns false when full
+    bool push(const T &t)
+    {
+        const size_t _end = end.load(std::memory_order_relaxed);
+        if (_end - start.load(std::memory_order_acquire) >= S)
+            return false;
+        data[_end & (S - 1)] = t;
+        end.store(_end + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer. Returns false when empty
+    bool shift(T &t)
+    {
+        const size_t _start = start.load(std::memory_order_relaxed);
+        if (_start == end.load(std::memory_order_acquire))
+            return false;
+        t = data[_start & (S - 1)];
+        start.store(_start + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const { return end.load() - start.load(); }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return S; }
+
+private:
+    std::atomic<size_t> start{0};
+    std::atomic<size_t> end{0};
+    T data[S];
+};
+
+/// Latest value channel for one producer and one consumer thread.
+/// The producer never waits, the consumer always sees a whole value, older values are dropped.
+template <typename T>
+struct TripleBuffer
+{
+    /// Producer. The slot to fill before publish()
+    T &back() { return buffers[backIndex]; }
+
+    /// Producer. Hands the back slot over and takes the stale one in return
+    void publish()
+    {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /// Consumer. Swaps in the latest published value, if there is one, and returns it.
+    /// The reference stays valid until the next read()
+    const T &read()
+    {
+        if (middle.load(std::memory_order_relaxed) & FRESH)
+            frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return buffers[frontIndex];
+    }
+
+private:
+    enum
+    {
+        INDEX = 0x3,
+        FRESH = 0x4
+    };
+
+    T buffers[3] = {};
+    std::atomic<int> middle{1};
+    int backIndex = 0;
+    int frontIndex = 2;
+};
+
+/// Append only storage for fixed size records, in chunks that never move, so growing never copies.
+/// clear() keeps the chunks for the next fill
+template <typename T>
+struct ChunkedArena
+{
+    /// Records per chunk. A new size drops the chunks, so set it between fills
+    void setChunkSize(size_t size)
+    {
+        size = std::max<size_t>(size, 1);
+        if (size == chunkSize)
+            return;
+        chunks.clear();
+        chunkSize = size;
+        count = 0;
+    }
+
+    /// Allocates chunks up front for n records in all
+    void reserve(size_t n)
+    {
+        while (chunks.size() * chunkSize < n)
+            chunks.emplace_back(new T[chunkSize]);
+    }
+
+    void push(const T &t)
+    {
+        if (count == chunks.size() * chunkSize)
+            chunks.emplace_back(new T[chunkSize]);
+        chunks[count / chunkSize][count % chunkSize] = t;
+        count++;
+    }
+
+    const T &operator[](size_t i) const { return chunks[i / chunkSize][i % chunkSize]; }
+    size_t size() const { return count; }
+    void clear() { count = 0; }
+
+private:
+    std::vector<std::unique_ptr<T[]>> chunks;
+    size_t chunkSize = 1024;
+    size_t count = 0;
+};
+
+/// Clock period from a gate or trigger input, T = float for one clock or float_4 for four.
+/// Edges are placed between samples by interpolating the rising crossing, a median of the last three
+/// periods rejects a single jittery edge, and a one pole loop settles the estimate. O(1) per sample.
+template <typename T>
+struct ClockTracker
+{
+    using Mask = decltype(T() > T());
+
+    T period;  // Smoothed, valid once locked
+    T elapsed; // Since the last edge
+    Mask locked = Mask(); // Initialized, reset() reads it for its type
+
+    ClockTracker() { reset(); }
+
+    void reset()
+    {
+        trigger.reset();
+        period = 0.f;
+        elapsed = 0.f;
+        previous = 0.f;
+        history[0] = history[1] = 0.f;
+        edges = T(0.f);
+        locked = none(locked);
+    }
+
+    /// Returns the lanes with an edge this sample
+    Mask process(T in, float dt)
+    {
+        const float SMOOTHING = 0.25f; // Loop gain on each new period
+        const float JUMP = 0.25f;      // Relative change taken as a new tempo rather than jitter
+        const float DROPOUT = 4.f;     // Periods without an edge before the clock counts as stopped
+
+        elapsed = elapsed + dt;
+        const Mask edge = trigger.process(in);
+
+        // Crossed the trigger's 1 V threshold this far back into the sample
+        const T before = clamp01((in - 1.f) / (in - previous)) * dt;
+        previous = in;
+
+        // Only a new edge after the clock stopped, so the pause doesn't count as a period
+        const Mask stopped = locked & (elapsed > period * DROPOUT);
+        edges = select(stopped, T(0.f), edges);
+        locked = locked & invert(stopped);
+
+        const T measured = elapsed - before;
+        const T median = lesser(greater(lesser(measured, history[0]), history[1]), greater(measured, history[0]));
+        const T estimate = select(edges >= 3.f, median, measured);
+        const Mask jump = invert(locked) | (absolute(estimate - period) > period * JUMP);
+        const T smoothed = select(jump, estimate, period + (estimate - period) * SMOOTHING);
+
+        const Mask measuring = edge & (edges >= 1.f);
+        period = select(measuring, smoothed, period);
+        locked = locked | measuring;
+        history[1] = select(edge, history[0], history[1]);
+        history[0] = select(edge, measured, history[0]);
+        edges = select(edge, lesser(edges + 1.f, T(3.f)), edges);
+        elapsed = select(edge, before, elapsed);
+        return edge;
+    }
+
+    /// Locked but the next edge is overdue
+    Mask isLate() { return locked & (elapsed > period); }
+
+private:
+    dsp::TSchmittTrigger<T> trigger;
+    T previous;
+    T history[2]; // Last raw periods, newest first
+    T edges;      // Edges since the clock (re)started, saturating at 3
+
+    // Scalar and SIMD spellings of the same operations
+    static bool none(bool) { return false; }
+    static simd::float_4 none(simd::float_4) { return simd::float_4::zero(); }
+    static bool invert(bool mask) { return !mask; }
+    static simd::float_4 invert(simd::float_4 mask) { return ~mask; }
+    static float select(bool mask, float a, float b) { return mask ? a : b; }
+    static simd::float_4 select(simd::float_4 mask, simd::float_4 a, simd::float_4 b) { return simd::ifelse(mask, a, b); }
+    static float lesser(float a, float b) { return std::fmin(a, b); }
+    static simd::float_4 lesser(simd::float_4 a, simd::float_4 b) { return simd::fmin(a, b); }
+    static float greater(float a, float b) { return std::fmax(a, b); }
+    static simd::float_4 greater(simd::float_4 a, simd::float_4 b) { return simd::fmax(a, b); }
+    static float absolute(float a) { return std::fabs(a); }
+    static simd::float_4 absolute(simd::float_4 a) { return simd::fabs(a); }
+    static T clamp01(T a) { return lesser(greater(a, T(0.f)), T(1.f)); }
+};
+
 struct RatioParam : ParamQuantity
 {
     float getDisplayValue() override
@@ -245,8 +473,8 @@ struct TToggleButton : app::SvgSwitch
 {
     TToggleButton()
     {
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/TToggleButton_0.svg")));
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/TToggleButton_1.svg")));
+        addFrame(Resources::getSvg(Resources::TOGGLE_BUTTON_0));
+        addFrame(Resources::getSvg(Resources::TOGGLE_BUTTON_1));
     }
 };
 
@@ -255,8 +483,8 @@ struct TMicroButton : app::SvgSwitch
     TMicroButton()
     {
         momentary = true;
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/TMicroButton_0.svg")));
-        addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/TMicroButton_1.svg")));
+        addFrame(Resources::getSvg(Resources::MICRO_BUTTON_0));
+        addFrame(Resources::getSvg(Resources::MICRO_BUTTON_1));
     }
 };
 
@@ -267,6 +495,6 @@ struct TTinyKnob : app::SvgKnob
         minAngle = -0.75 * M_PI;
         maxAngle = 0.75 * M_PI;
 
-        setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/TTinyKnob.svg")));
+        setSvg(Resources::getSvg(Resources::TINY_KNOB));
     }
 };
\ No newline at end of file
@@ -0,0 +1,9 @@
+#include "penners.hpp"
+
+// Defined once here, so any module can include penners.hpp
+const char *Ease::TypeStrings[] = {
+    "Linear", "Sine", "Expo", "Circ", "Cubic", "Quad", "Quart", "Quint", "Back", "Elastic", "Bounce"};
+const char *Ease::TypeIdStrings[] = {
+    "Line", "Sine", "Expo", "Circ", "Cube", "Quad", "Qurt", "Qunt", "Back", "Elas", "Bunc"};
+const char *Ease::ModeStrings[] = {"In", "Out", "Both"};
+const char *Ease::PrecisionStrings[] = {"Exact", "Table", "Economy"};
@@ -6,6 +6,7 @@ Plugin* pluginInstance;
 
 void init(Plugin* p) {
 	pluginInstance = p;
+	Resources::init(p);
 
 	// Add modules here
 	p->addModel(modelTension);
@@ -0,0 +1,353 @@
+//////////////////////////////////////////////////////////////////////////
+//  Beyond Help Module Collection
+//  for VCV Rack By Juriel Garcia Sanchez
+//
+//  Standard MIDI File encoding for TenseMidiRecorder's takes
+//
+//  See ./LICENSE.md for all licenses
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "components.hpp"
+#include <cstdio>
+#include <algorithm>
+#if defined ARCH_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/// A recorded event as the writer keeps it until the take is written
+struct TakeEvent
+{
+    enum
+    {
+        MARKER = 0xFE, // Not channel statuses
+        TEMPO = 0xFF
+    };
+
+    uint32_t tick;
+    uint8_t status;   // Channel message, MARKER or TEMPO
+    uint8_t bytes[3]; // Track then the two data bytes, for a tempo the microseconds per QN, for a marker the index of its text, big endian
+};
+static_assert(sizeof(TakeEvent) == 8, "TakeEvent should pack into 8 bytes");
+
+/// A recorded controller value, in CC steps
+struct ControlPoint
+{
+    uint32_t tick;
+    float value;
+};
+
+/// Converts sample frames to SMF ticks once per event.
+/// Each tempo change starts a segment at a whole tick, and the segment keeps the time a player
+/// will compute for that tick from the tempo map. Ticks are found from the audio time against
+/// it, so rounding stays under half a tick and never accumulates, however long the take.
+struct TickClock
+{
+    explicit TickClock(uint16_t ticksPerQN) : ticksPerQN(ticksPerQN) {}
+
+    void reset(double sampleRate)
+    {
+        segmentFrame = 0;
+        segmentFrameTime = 0.0;
+        segmentTick = 0;
+        segmentTickTime = 0.0;
+        secondsPerTick = 0.5 / ticksPerQN;
+        this->sampleRate = sampleRate;
+        setTempo(0, 120.0);
+    }
+
+    void setSampleRate(uint64_t frame, double sampleRate)
+    {
+        segmentFrameTime = getTime(frame);
+        segmentFrame = frame;
+        this->sampleRate = sampleRate;
+    }
+
+    /// Returns the tempo in microseconds per quarter note, as written in the tempo meta event
+    uint32_t setTempo(uint64_t frame, double bpm)
+    {
+        const uint32_t tick = toTick(frame);
+        segmentTickTime += (tick - segmentTick) * secondsPerTick;
+        segmentTick = tick;
+
+        // Round to what the file can hold, so the player's tempo map matches ours exactly
+        microsecondsPerQN = uint32_t(std::round(60000000.0 / clamp(bpm, 1.0, 1000.0)));
+        secondsPerTick = microsecondsPerQN / (1000000.0 * ticksPerQN);
+        return microsecondsPerQN;
+    }
+
+    uint32_t toTick(uint64_t frame) const
+    {
+        const double ticks = (getTime(frame) - segmentTickTime) / secondsPerTick;
+        return segmentTick + uint32_t(std::llround(std::fmax(ticks, 0.0)));
+    }
+
+private:
+    uint16_t ticksPerQN;
+    uint64_t segmentFrame = 0;
+    double segmentFrameTime = 0.0; // Audio time at segmentFrame
+    uint32_t segmentTick = 0;
+    double segmentTickTime = 0.0;  // Playback time at segmentTick
+    double sampleRate = 44100.0;
+    double secondsPerTick = 0.0;
+    uint32_t microsecondsPerQN = 500000;
+
+    double getTime(uint64_t frame) const
+    {
+        return segmentFrameTime + (frame - segmentFrame) / sampleRate;
+    }
+};
+
+/// Thins a controller lane to the fewest points whose ramps stay within half the tolerance of what
+/// was recorded (Ramer-Douglas-Peucker), then draws the ramps back as steps of up to the tolerance,
+/// since players hold a controller at its last value rather than ramp to the next. Each half of the
+/// tolerance bounds one stage, so the file stays within the whole of it, plus rounding to 7 bits
+struct AutomationSimplifier
+{
+    /// Appends the lane's events to events, with the given status and track. Points are in time order
+    void simplify(const std::vector<ControlPoint> &points, float tolerance, uint8_t status, uint8_t track, uint8_t controller, std::vector<TakeEvent> &events)
+    {
+        const size_t count = points.size();
+        if (count == 0)
+            return;
+
+        keep.assign(count, false);
+        keep[0] = keep[count - 1] = true;
+
+        // Split each span at its worst point until every point is within tolerance of its span's ramp
+        spans.clear();
+        if (count > 2)
+            spans.push_back(std::make_pair(size_t(0), count - 1));
+        while (!spans.empty())
+        {
+            const size_t first = spans.back().first;
+            const size_t last = spans.back().second;
+            spans.pop_back();
+
+            float worst = tolerance / 2.f;
+            size_t split = 0;
+            for (size_t i = first + 1; i < last; i++)
+            {
+                const float error = std::fabs(points[i].value - interpolate(points[first], points[last], points[i].tick));
+                if (error > worst)
+                {
+                    worst = error;
+                    split = i;
+                }
+            }
+
+            if (split == 0)
+                continue;
+            keep[split] = true;
+            if (split - first > 1)
+                spans.push_back(std::make_pair(first, split));
+            if (last - split > 1)
+                spans.push_back(std::make_pair(split, last));
+        }
+
+        const int stepSize = std::max(1, (int)std::round(tolerance));
+        int value = toStep(points[0].value);
+        events.push_back(TakeEvent{points[0].tick, status, {track, controller, uint8_t(value)}});
+
+        size_t from = 0;
+        for (size_t to = 1; to < count; to++)
+        {
+            if (!keep[to])
+                continue;
+
+            // Each step lands where the ramp is halfway to it, the last one on the point itself
+            const ControlPoint &a = points[from];
+            const ControlPoint &b = points[to];
+            const int target = toStep(b.value);
+            while (value != target)
+            {
+                const int next = std::abs(target - value) > stepSize ? value + (target > value ? stepSize : -stepSize) : target;
+                const double crossing = ((value + next) / 2.0 - a.value) / (b.value - a.value);
+                value = next;
+                const uint32_t tick = a.tick + uint32_t(clamp(crossing, 0.0, 1.0) * (b.tick - a.tick) + 0.5);
+                events.push_back(TakeEvent{tick, status, {track, controller, uint8_t(value)}});
+            }
+            from = to;
+        }
+    }
+
+private:
+    std::vector<bool> keep;
+    std::vector<std::pair<size_t, size_t>> spans;
+
+    static float interpolate(const ControlPoint &a, const ControlPoint &b, uint32_t tick)
+    {
+        if (b.tick == a.tick)
+            return b.value;
+        return a.value + float(double(tick - a.tick) / (b.tick - a.tick)) * (b.value - a.value);
+    }
+
+    static int toStep(float value) { return clamp((int)std::round(value), 0, 127); }
+};
+
+/// Encodes the events of one MTrk chunk, delta times as variable length quantities and
+/// channel messages with running status. bytes is kept between uses, so it stops allocating once grown
+struct SmfTrackEncoder
+{
+    std::vector<uint8_t> bytes;
+
+    void reset()
+    {
+        bytes.clear();
+        lastTick = 0;
+        runningStatus = 0;
+    }
+
+    /// Clears bytes that have been written out, keeping the tick for the next delta. Running status
+    /// restarts, as the writer may put a meta event between the pieces
+    void clearWritten()
+    {
+        bytes.clear();
+        runningStatus = 0;
+    }
+
+    /// Ticks must not go backwards
+    void addEvent(uint32_t tick, uint8_t status, uint8_t data1, uint8_t data2)
+    {
+        addDelta(tick);
+        if (status != runningStatus)
+            bytes.push_back(status);
+        runningStatus = status;
+        bytes.push_back(data1);
+        bytes.push_back(data2);
+    }
+
+    void addTempo(uint32_t tick, uint32_t microsecondsPerQN)
+    {
+        addDelta(tick);
+        const uint8_t tempo[] = {0xFF, 0x51, 0x03, uint8_t(microsecondsPerQN >> 16), uint8_t(microsecondsPerQN >> 8), uint8_t(microsecondsPerQN)};
+        bytes.insert(bytes.end(), tempo, tempo + sizeof(tempo));
+
+        // Readers may drop running status after a meta event
+        runningStatus = 0;
+    }
+
+    void addMarker(uint32_t tick, const std::string &text)
+    {
+        addDelta(tick);
+        bytes.push_back(0xFF);
+        bytes.push_back(0x06);
+        addVariableLength(text.size());
+        bytes.insert(bytes.end(), text.begin(), text.end());
+        runningStatus = 0;
+    }
+
+private:
+    uint32_t lastTick = 0;
+    uint8_t runningStatus = 0;
+
+    void addDelta(uint32_t tick)
+    {
+        addVariableLength(tick > lastTick ? tick - lastTick : 0);
+        lastTick = std::max(tick, lastTick);
+    }
+
+    void addVariableLength(uint32_t value)
+    {
+        uint8_t vlq[5];
+        int count = 0;
+        do
+        {
+            vlq[count++] = value & 0x7F;
+            value >>= 7;
+        } while (value);
+
+        while (count > 1)
+            bytes.push_back(vlq[--count] | 0x80);
+        bytes.push_back(vlq[0]);
+    }
+};
+
+/// Makes sure what was written reached the disk
+static inline bool syncFile(std::FILE *file)
+{
+#if defined ARCH_WIN
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+/// Writes a whole take in one pass over its events, format 0 for a single track, otherwise format 1
+/// with the tempo map and markers on the first track. The take is in time order already, so nothing is sorted;
+/// automation, in time order too, is merged in as it goes. The file goes out in a single write, then is synced
+struct SmfTakeEncoder
+{
+    static constexpr int MAX_TRACKS = 16;
+
+    /// Returns false unless the whole file was written
+    bool write(const std::string &path, const ChunkedArena<TakeEvent> &take, uint16_t ticksPerQN,
+               const std::vector<TakeEvent> &automation = std::vector<TakeEvent>(), const std::vector<std::string> &markers = std::vector<std::string>())
+    {
+        for (int i = 0; i < MAX_TRACKS; i++)
+            tracks[i].reset();
+
+        int trackCount = 1;
+        size_t i = 0;
+        size_t next = 0;
+        while (i < take.size() || next < automation.size())
+        {
+            // Controllers go first on a shared tick, so a note starts with its automation in place
+            const bool isAutomation = next < automation.size() && (i == take.size() || automation[next].tick <= take[i].tick);
+            const TakeEvent &event = isAutomation ? automation[next++] : take[i++];
+
+            if (event.status == TakeEvent::TEMPO)
+            {
+                tracks[0].addTempo(event.tick, event.bytes[0] << 16 | event.bytes[1] << 8 | event.bytes[2]);
+                continue;
+            }
+            if (event.status == TakeEvent::MARKER)
+            {
+                tracks[0].addMarker(event.tick, markers[event.bytes[0] << 16 | event.bytes[1] << 8 | event.bytes[2]]);
+                continue;
+            }
+
+            const int track = event.bytes[0] % MAX_TRACKS;
+            trackCount = std::max(trackCount, track + 1);
+            tracks[track].addEvent(event.tick, event.status, event.bytes[1], event.bytes[2]);
+        }
+
+        output.clear();
+        const uint8_t header[] = {
+            'M', 'T', 'h', 'd', 0, 0, 0, 6,
+            0, uint8_t(trackCount > 1 ? 1 : 0),
+            0, uint8_t(trackCount),
+            uint8_t(ticksPerQN >> 8), uint8_t(ticksPerQN & 0xFF),
+        };
+        output.insert(output.end(), header, header + sizeof(header));
+
+        const uint8_t endOfTrack[] = {0x00, 0xFF, 0x2F, 0x00};
+        for (int i = 0; i < trackCount; i++)
+        {
+            const std::vector<uint8_t> &bytes = tracks[i].bytes;
+            const uint32_t length = bytes.size() + sizeof(endOfTrack);
+            const uint8_t trackHeader[] = {'M', 'T', 'r', 'k', uint8_t(length >> 24), uint8_t(length >> 16), uint8_t(length >> 8), uint8_t(length)};
+            output.insert(output.end(), trackHeader, trackHeader + sizeof(trackHeader));
+            output.insert(output.end(), bytes.begin(), bytes.end());
+            output.insert(output.end(), endOfTrack, endOfTrack + sizeof(endOfTrack));
+        }
+
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+
+        // Unbuffered, so the take goes out in one write rather than through stdio's buffer
+        std::setvbuf(file, NULL, _IONBF, 0);
+        bool success = std::fwrite(output.data(), output.size(), 1, file) == 1;
+        success &= syncFile(file);
+        success &= std::fclose(file) == 0;
+        return success;
+    }
+
+private:
+    SmfTrackEncoder tracks[MAX_TRACKS];
+    std::vector<uint8_t> output;
+};
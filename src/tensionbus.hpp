@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////
+//  Beyond Help Module Collection
+//  for VCV Rack By Juriel Garcia Sanchez
+//
+//  Expander messages from Tension to a TenseMidiRecorder on its right
+//
+//  See ./LICENSE.md for all licenses
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+/// Where one of Tension's curves stands as of its last control step
+struct TensionVoice
+{
+    float shape;    // Ease::Type, between two of them while the shape is morphing
+    float duration; // Seconds for a whole run of the curve
+    float phase;    // 0 ... 1 through the run
+    int8_t mode;    // Ease::Mode
+    bool falling;   // Runs down from 10 V, after the trigger went high
+    bool restarted; // A trigger or reset started the run in this control step
+    bool stretching; // The clock is late, so duration grows with the wait rather than following the clock
+};
+
+/// Written by Tension into the producer message of the recorder on its right every frame.
+/// channels is 0 on frames without a control step, so each step is only read once
+struct TensionBusMessage
+{
+    enum
+    {
+        MAX_VOICES = 16
+    };
+
+    int channels = 0;
+    TensionVoice voices[MAX_VOICES];
+};